@@ -13,6 +13,7 @@
 #include "kernel/ComponentFactory.h"
 #include "kernel/ComponentManager.h"
 #include "kernel/Log.h"
+#include "../VelodyneComponent/VelodyneCompactScan.h"
 
 #include <iostream>
 #include <string>
@@ -30,7 +31,8 @@ static const string kVelodyneMemoryName = "VELODYNE";
 /// Constructor.
 DbtPlyVelodyneManager::DbtPlyVelodyneManager(QString name)
     : DbtPlyFileManager (name)
-    , shMem_(NULL)
+    , shMemSlots_(kVelodyneScanRingDefaultSlots)
+    , assembler_(this)
 {
     LOG_TRACE("constructor");
 }
@@ -41,32 +43,80 @@ DbtPlyVelodyneManager::~DbtPlyVelodyneManager()
     LOG_TRACE("destructor");
 }
 
-void DbtPlyVelodyneManager::processData(road_time_t /*time*/, road_timerange_t /*timeRange*/, void * buffer)
+void DbtPlyVelodyneManager::processData(road_time_t time, road_timerange_t /*timeRange*/, void * buffer)
 {
     if (NULL == buffer) {
         LOG_WARN("processing data: NULL buffer");
 		return;
     }
 
+    // raw packet recorded with recordFormat="packets", the revolutions are assembled here
+    const VelodynePacketRecordHeader * packetHeader = (const VelodynePacketRecordHeader *)buffer;
+    if (kVelodynePacketRecordMagic == packetHeader->magic) {
+        assembler_.processDatagram(time, (const char *)(packetHeader + 1), packetHeader->size);
+        return;
+    }
+
+    // the record is either a whole VelodynePolarData or a compact one, it is forwarded as is
+    size_t recordSize = velodyneScanRecordSize(buffer);
     if (mVerbose) {
-        VelodynePolarData & vpd = *(VelodynePolarData *)buffer;
+        int range = isVelodyneCompactScan(buffer)
+                ? ((VelodyneCompactScanHeader *)buffer)->range
+                : ((VelodynePolarData *)buffer)->range;
         cout << "[VELODYNE]:\t"
-             << "#range=" << vpd.range << "\n"
+             << "#range=" << range << "\t"
+             << "size=" << recordSize << "\n"
                 ;
     }
 
-    memcpy(&sphericData_, buffer, sizeof(VelodynePolarData) );
-    shMem_->write(&sphericData_, sizeof(VelodynePolarData) );
+    if (recordSize > sizeof(VelodynePolarData)) {
+        LOG_WARN("corrupted Velodyne record of " << recordSize << " bytes");
+        return;
+    }
+    scanRing_.publish(buffer, (int) recordSize);
+}
+
+VelodynePolarData * DbtPlyVelodyneManager::scanCompleted(VelodynePolarData * scan)
+{
+    if (mVerbose) {
+        cout << "[VELODYNE]:\t"
+             << "#range=" << scan->range << "\t"
+             << "assembled from packets" << "\n"
+                ;
+    }
+    scanRing_.publish(scan, sizeof(VelodynePolarData));
+    return scan;
+}
+
+ComponentBase::COMPONENT_CONFIGURATION DbtPlyVelodyneManager::configureComponent(XmlComponentConfig config)
+{
+    shMemName_ = kVelodyneMemoryName.c_str();
+    if (!param.getProperty("shmem").isNull()) {
+        shMemName_ = param.getProperty("shmem");
+    }
+    LOG_INFO("property shmem=\"" << shMemName_ << "\"");
+    // same number of slots as the readers of the ring
+    if (!param.getProperty("shmemSlots").isNull()) {
+        bool ok;
+        shMemSlots_ = param.getProperty("shmemSlots").toInt(&ok);
+        if (!ok || (shMemSlots_ < 1) || (shMemSlots_ > kVelodyneScanRingMaxSlots)) {
+            LOG_ERROR("invalid property shmemSlots=\"" << param.getProperty("shmemSlots")
+                      << "\", expected 1 to " << kVelodyneScanRingMaxSlots);
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property shmemSlots=\"" << shMemSlots_ << "\"");
+    return DbtPlyFileManager::configureComponent(config);
 }
 
 void DbtPlyVelodyneManager::startActivity()
 {
     LOG_TRACE("starting activity...");
 
-    shMem_ = new ShMem(kVelodyneMemoryName.c_str(), sizeof(VelodynePolarData));
-    if (!shMem_) {
+    if (!scanRing_.open(shMemName_.toStdString(), shMemSlots_, sizeof(VelodynePolarData))) {
         LOG_FATAL("cannot create Velodyne shared memory");
     }
+    assembler_.reset(&packetScan_);
 	DbtPlyFileManager::startActivity();
     LOG_TRACE("started activity");
 }
@@ -76,8 +126,7 @@ void DbtPlyVelodyneManager::stopActivity()
     LOG_TRACE("stopping activity...");
 
     DbtPlyFileManager::stopActivity();
-    delete shMem_;  // it is ok to delete a NULL pointer
-    shMem_ = NULL;
+    scanRing_.close();
     LOG_TRACE("stopped activity");
 }
 
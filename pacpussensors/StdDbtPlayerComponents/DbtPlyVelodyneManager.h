@@ -14,8 +14,9 @@
 #include <qobject.h>
 
 #include "DbitePlayer/DbtPlyFileManager.h"
-#include "PacpusTools/ShMem.h"
 #include "../VelodyneComponent/structure_velodyne.h"
+#include "../VelodyneComponent/VelodyneScanAssembler.h"
+#include "../VelodyneComponent/VelodyneScanRing.h"
 
 // Export macro for DbtPlyVelodyne DLL for Windows only
 #ifdef WIN32
@@ -35,6 +36,7 @@ namespace pacpus {
 
 class DBTPLYVELODYNE_API DbtPlyVelodyneManager
         : public DbtPlyFileManager
+        , public VelodyneScanSink
 {
     Q_OBJECT
 
@@ -45,14 +47,23 @@ public:
     void displayUI();
 
 protected:
+    virtual COMPONENT_CONFIGURATION configureComponent(XmlComponentConfig config);
     void processData(road_time_t, road_timerange_t, void * dataBuffer);
     virtual void startActivity();
     virtual void stopActivity();
+    /// a revolution rebuilt from packet records is exposed
+    VelodynePolarData * scanCompleted(VelodynePolarData * scan);
 
 private:
-    ShMem * shMem_;
+    /// ring of revolutions laid out as the one of the VelodyneComponent
+    VelodyneScanRingWriter scanRing_;
+    /// same name and number of slots as the VelodyneComponent which recorded the file
+    QString shMemName_;
+    int shMemSlots_;
 
-    VelodynePolarData sphericData_;
+    /// rebuilds the revolutions of a file of raw packet records
+    VelodyneScanAssembler assembler_;
+    VelodynePolarData packetScan_;
 
     road_time_t tic_;
     void tic();
@@ -0,0 +1,132 @@
+/// @file
+/// Helpers for the compact revolution records, which only hold the packet
+/// timings and the valid blocks of a VelodynePolarData behind a
+/// VelodyneCompactScanHeader
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNECOMPACTSCAN_H
+#define VELODYNECOMPACTSCAN_H
+
+#include <cstddef>
+#include <cstring>
+
+#include "kernel/road_time.h"
+#include "structure_velodyne.h"
+
+namespace pacpus {
+
+/// Tells if a record, read from a dbt file or a shared memory, is compact or a whole VelodynePolarData
+inline bool isVelodyneCompactScan(const void * record)
+{
+    return kVelodyneCompactScanMagic == static_cast<const VelodyneCompactScanHeader *>(record)->magic;
+}
+
+/// Size of a compact record holding packetCount packet timings and range blocks
+inline size_t velodyneCompactScanSize(int range, int packetCount)
+{
+    return sizeof(VelodyneCompactScanHeader) + packetCount * sizeof(VelodynePacketTiming) + range * VELODYNE_BLOCK_SIZE;
+}
+
+/// Size of a record of either format
+inline size_t velodyneScanRecordSize(const void * record)
+{
+    if (isVelodyneCompactScan(record)) {
+        const VelodyneCompactScanHeader * header = static_cast<const VelodyneCompactScanHeader *>(record);
+        return velodyneCompactScanSize(header->range, header->packetCount);
+    }
+    return sizeof(VelodynePolarData);
+}
+
+/// Tells if count packet timings may describe the blocks [0, range): each
+/// packet starts after the previous one, within the range, and did not
+/// arrive before it
+inline bool isVelodynePacketTimingValid(const VelodynePacketTiming * timing, int count, int range)
+{
+    if ((count < 0) || (VELODYNE_MAX_PACKETS_PER_SCAN < count)) {
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (timing[i].firstBlock >= range) {
+            return false;
+        }
+        if ((i > 0) && ((timing[i].firstBlock <= timing[i - 1].firstBlock)
+                        || (timing[i].arrivalOffset < timing[i - 1].arrivalOffset))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Fills scan from a record of either format. The blocks after range are
+/// left untouched. Returns false if the record is corrupted.
+inline bool readVelodyneScanRecord(const void * record, VelodynePolarData * scan)
+{
+    if (!isVelodyneCompactScan(record)) {
+        memcpy(scan, record, sizeof(VelodynePolarData));
+        // the bytes of packetCount and packetTiming were not filled in older records
+        if (!isVelodynePacketTimingValid(scan->packetTiming, scan->packetCount, scan->range)) {
+            scan->packetCount = 0;
+        }
+        return true;
+    }
+
+    const VelodyneCompactScanHeader * header = static_cast<const VelodyneCompactScanHeader *>(record);
+    if ((header->range < 0) || (VELODYNE_SCAN_SIZE < header->range)
+            || (header->packetCount < 0) || (VELODYNE_MAX_PACKETS_PER_SCAN < header->packetCount)) {
+        return false;
+    }
+    const VelodynePacketTiming * timing = reinterpret_cast<const VelodynePacketTiming *>(header + 1);
+    memcpy(scan->packetTiming, timing, header->packetCount * sizeof(VelodynePacketTiming));
+    memcpy(scan->polarData, timing + header->packetCount, header->range * VELODYNE_BLOCK_SIZE);
+    scan->time = header->time;
+    scan->timerange = header->timerange;
+    scan->range = header->range;
+    scan->packetCount = header->packetCount;
+    if (!isVelodynePacketTimingValid(scan->packetTiming, scan->packetCount, scan->range)) {
+        scan->packetCount = 0;
+    }
+    return true;
+}
+
+/// Gives the blocks of a record of either format where they are, without
+/// copying them, and fills info with its range, times and packetCount.
+/// packetTiming, if not NULL, receives the info->packetCount timings of the
+/// packets, also without copy. Returns NULL if the record is corrupted.
+inline const VelodyneBlock * velodyneScanRecordBlocks(const void * record, VelodyneCompactScanHeader * info,
+                                                      const VelodynePacketTiming ** packetTiming = NULL)
+{
+    const VelodynePacketTiming * timing;
+    const VelodyneBlock * blocks;
+    if (!isVelodyneCompactScan(record)) {
+        const VelodynePolarData * scan = static_cast<const VelodynePolarData *>(record);
+        info->range = scan->range;
+        info->time = scan->time;
+        info->timerange = scan->timerange;
+        info->packetCount = scan->packetCount;
+        timing = scan->packetTiming;
+        blocks = scan->polarData;
+    } else {
+        const VelodyneCompactScanHeader * header = static_cast<const VelodyneCompactScanHeader *>(record);
+        if ((header->range < 0) || (VELODYNE_SCAN_SIZE < header->range)
+                || (header->packetCount < 0) || (VELODYNE_MAX_PACKETS_PER_SCAN < header->packetCount)) {
+            return NULL;
+        }
+        *info = *header;
+        timing = reinterpret_cast<const VelodynePacketTiming *>(header + 1);
+        blocks = reinterpret_cast<const VelodyneBlock *>(timing + header->packetCount);
+    }
+    if (!isVelodynePacketTimingValid(timing, info->packetCount, info->range)) {
+        info->packetCount = 0;
+    }
+    if (packetTiming) {
+        *packetTiming = timing;
+    }
+    return blocks;
+}
+
+} // namespace pacpus
+
+#endif // VELODYNECOMPACTSCAN_H
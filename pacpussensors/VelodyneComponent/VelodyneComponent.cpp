@@ -17,9 +17,11 @@
 #include "kernel/ComponentFactory.h"
 #include "kernel/DbiteFileTypes.h"
 #include "kernel/Log.h"
+#include "VelodyneThreadTuning.h"
 
-#include <QtEndian>
 #include <QUdpSocket>
+#include <climits>
+#include <cstring>
 #include <string>
 
 using namespace pacpus;
@@ -37,15 +39,92 @@ static const string kDefaultHostAddress = "0.0.0.0";
 static const uint16_t kDefaultHostPort = 2368;
 
 static const string kPropertyRecording = "recording";
+static const string kPropertyReceiver = "receiver";
+static const string kPropertyRingSize = "ringSize";
+static const string kPropertyScanBufferCount = "scanBufferCount";
+static const string kPropertyRecordQueueSize = "recordQueueSize";
+static const string kPropertyRecordPreallocation = "recordPreallocationMB";
+static const string kPropertyRecordFormat = "recordFormat";
+static const string kPropertyAssembly = "assembly";
+static const string kPropertyPcapFile = "pcapFile";
+static const string kPropertyPcapPacing = "pcapPacing";
+static const string kPropertySectorWidth = "sectorWidth";
+static const string kPropertyHostAddress = "velodyneIP";
+static const string kPropertyHostPort = "velodynePort";
+static const string kPropertyMulticastGroup = "multicastGroup";
+static const string kPropertyReceiveCore = "receiveCore";
+static const string kPropertyReceivePriority = "receivePriority";
+static const string kPropertyAssemblyCore = "assemblyCore";
+static const string kPropertyAssemblyPriority = "assemblyPriority";
+static const string kPropertyReceiveBufferSize = "receiveBufferSize";
+static const string kPropertyBusyPoll = "busyPollUs";
+static const string kPropertySharedMemoryName = "shmem";
+static const string kPropertySharedMemorySlots = "shmemSlots";
+static const string kPropertyHugePages = "hugePages";
+static const string kPropertyLockMemory = "lockMemory";
+static const string kPropertyOutputFile = "outputFile";
+
+/// Default capacity of the packet ring, more than 1.5 s of data at ~2600 packets/s
+static const int kDefaultRingSize = 4096;
+
+/// Default number of revolutions waiting to be written, more than 1 s at 15 Hz
+static const int kDefaultRecordQueueSize = 16;
+
+/// Default number of revolution buffers, enough for a full recording queue
+static const int kDefaultScanBufferCount = kDefaultRecordQueueSize + 4;
+
+/// Time slept by the assembly thread when the packet ring is empty
+static const unsigned long kAssemblyIdleSleepUs = 500;
+
+/// Period of the packet ring overrun check
+static const road_timerange_t kRingCheckPeriodUs = 1000000;
+
+/// Period of the update of the shared statistics
+static const road_timerange_t kStatisticsPeriodUs = 200000;
+
+/// Highest number of revolutions kept in the shared memory
+static const int kMaxScanRingSlots = kVelodyneScanRingMaxSlots;
+
+/// Highest core number accepted for the threads, the size of a Linux cpu_set_t
+static const int kMaxCore = 1023;
+
+/// Maximal time to wait for the reception and assembly threads to stop
+static const unsigned long kMaxWaitForThreadTimeMs = 2000;
 
 static const string kVelodyneSharedMemoryName = "VELODYNE";
+/// appended to the name of the shared memory of the revolutions
+static const string kSectorSharedMemorySuffix = "_SECTORS";
 static const string kDefaultOutputFilename = "velodyne_spheric.dbt";
 
 //////////////////////////////////////////////////////////////////////////
 /// Constructor
 VelodyneComponent::VelodyneComponent(QString name)
     : ComponentBase(name)
+    , mReceiverMode(QtReceiver)
+    , mReceiver(NULL)
+    , mPcapReader(NULL)
+    , mPcapPacing(VelodynePcapReader::RealTimePacing)
+    , mRing(NULL)
+    , mRingSize(kDefaultRingSize)
+    , mSocket(NULL)
     , mPort(kDefaultHostPort)
+    , mSharedMemoryName(kVelodyneSharedMemoryName)
+    , mSectorSharedMemoryName(kVelodyneSharedMemoryName + kSectorSharedMemorySuffix)
+    , mOutputFilename(kDefaultOutputFilename)
+    , mScanPool(NULL)
+    , mScanBufferCount(kDefaultScanBufferCount)
+    , mAssembler(this)
+    , mFullBuffer(NULL)
+    , mSectorWidth(0)
+    , mRecorder(NULL)
+    , mRecordQueueSize(kDefaultRecordQueueSize)
+    , mRecordPreallocationMB(0)
+    , mRecordFormat(FixedRecords)
+    , mPacketRecorder(NULL)
+    , mAssembly(true)
+    , mScanRingSlots(kVelodyneScanRingDefaultSlots)
+    , mStatisticsShMem(NULL)
+    , mLastStatisticsTime(0)
 {
     LOG_TRACE("constructor(" << name << ")");
     
@@ -71,61 +150,168 @@ VelodyneComponent::~VelodyneComponent()
 /// Called by the ComponentManager to start the component
 void VelodyneComponent::startActivity()
 {
-    mStartOfScan = false;
-    mEndOfScan = false;
-    mBlockIndex = 0;
-    mCurrentVelodyneData = 0;
-    mPreviousAngle = 0;
-    mVelodyneData = &(mVelodyneDataBuffer[mCurrentVelodyneData]);
+    mScanPool = new VelodyneScanPool(mScanBufferCount, mMemorySettings);
+    mAssembler.reset(mScanPool->acquire());
+    mFullBuffer = NULL;
+
+    mRing = new VelodynePacketRing(mRingSize, mMemorySettings);
+    LOG_INFO("packet ring capacity = " << mRing->capacity());
+
+    memset(&mStatistics, 0, sizeof(mStatistics));
+    mStatistics.magic = kVelodyneStatisticsMagic;
+    mLastStatisticsTime = road_time();
 
     mRunning = true;
     initialize();
+
+    // start the assembly thread
+    QThread::start();
 }
 
 //////////////////////////////////////////////////////////////////////////
-/// TODO: doc
+/// Assembly thread: consumes the datagrams queued in the packet ring by
+/// the reception, assembles the revolutions, exposes and records them
 void VelodyneComponent::run()
-{ 
-    initialize();
-    exec(); // launch the exec loop, blocking until receiving exit() signal ...
-    close();
+{
+    tuneCurrentThread("assembly", mAssemblyThread);
+
+    road_time_t lastCheckTime = road_time();
+    int lastDropCount = 0;
+
+    while (mRunning) {
+        int count;
+        const VelodyneDatagram * datagrams = mRing->peek(&count);
+        if (0 == count) {
+            QThread::usleep(kAssemblyIdleSleepUs);
+        } else {
+            if (mPacketRecorder) {
+                mPacketRecorder->enqueue(datagrams, count);
+            }
+            if (mAssembly) {
+                for (int i = 0; i < count; ++i) {
+                    handleDatagram(datagrams[i].time, datagrams[i].data, datagrams[i].size);
+                }
+            }
+            mRing->release(count);
+        }
+
+        road_time_t now = road_time();
+        if (now - mLastStatisticsTime > (road_time_t) kStatisticsPeriodUs) {
+            publishStatistics(now);
+        }
+        if (now - lastCheckTime > (road_time_t) kRingCheckPeriodUs) {
+            int dropCount = mRing->dropCount();
+            if (dropCount != lastDropCount) {
+                LOG_WARN("packet ring overrun: " << dropCount - lastDropCount << " datagrams dropped"
+                         << ", high-water mark = " << mRing->highWaterMark() << "/" << mRing->capacity());
+                lastDropCount = dropCount;
+            }
+            lastCheckTime = now;
+        }
+    }
+    LOG_INFO("ended assembly thread");
 }
 
 //////////////////////////////////////////////////////////////////////////
 /// TODO: doc
 void VelodyneComponent::initialize()
 {
-    if (recording) {
-        mVelodyneSphericDataFile.open(kDefaultOutputFilename, WriteMode, VELODYNE_RAW_SPHERIC_DATA, sizeof(VelodynePolarData));
+    if (recording && (PacketRecords == mRecordFormat)) {
+        mPacketRecorder = new VelodynePacketRecorder(mRingSize);
+        if (!mPacketRecorder->open(mOutputFilename, mRecordPreallocationMB * 1024 * 1024)) {
+            LOG_ERROR("cannot record Velodyne packets");
+            delete mPacketRecorder;
+            mPacketRecorder = NULL;
+        }
+    } else if (recording) {
+        mRecorder = new VelodyneRecorder(mScanPool, mRecordQueueSize);
+        if (!mRecorder->open(mOutputFilename, CompactRecords == mRecordFormat, mRecordPreallocationMB * 1024 * 1024)) {
+            LOG_ERROR("cannot record Velodyne data");
+            delete mRecorder;
+            mRecorder = NULL;
+        }
     }
-
-    initSocket();
-    if (!connect(mSocket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()))) {
-        LOG_ERROR("cannot connect SIGNAL(readyRead()) to SLOT(readPendingDatagrams())");
+    if (!mAssembly && !mPacketRecorder) {
+        LOG_WARN("the packets are not recorded, the revolutions are assembled anyway");
+        mAssembly = true;
     }
 
-    mShMem = new ShMem(kVelodyneSharedMemoryName.c_str(), sizeof(VelodynePolarData) );
-    if (!mShMem) {
+    // without assembly, no revolution nor sector is published
+    if (mAssembly && !mScanRing.open(mSharedMemoryName, mScanRingSlots, sizeof(VelodynePolarData), mMemorySettings)) {
         LOG_FATAL("cannot create Velodyne shared memory");
         return;
     }
+
+    mStatisticsShMem = new ShMem((mSharedMemoryName + VELODYNE_STATISTICS_SUFFIX).c_str(), sizeof(VelodyneStatistics));
+
+    if (mAssembly && (mSectorWidth > 0) && !mSectorStreamer.open(mSectorSharedMemoryName, mSectorWidth)) {
+        LOG_ERROR("cannot stream the Velodyne sectors");
+    }
+
+    if (PcapReceiver == mReceiverMode) {
+        mPcapReader = new VelodynePcapReader(mRing);
+        mPcapReader->setThreadSettings(mReceiveThread);
+        if (mPcapReader->open(mPcapFile, mPort, mPcapPacing)) {
+            mPcapReader->start();
+        } else {
+            LOG_ERROR("cannot replay the pcap file, no Velodyne data will be acquired");
+            delete mPcapReader;
+            mPcapReader = NULL;
+        }
+        return;
+    }
+
+    if ((RecvmmsgReceiver == mReceiverMode) || (IoUringReceiver == mReceiverMode)) {
+        if (IoUringReceiver == mReceiverMode) {
+            mReceiver = new VelodyneUringReceiver(this);
+        } else {
+            mReceiver = new VelodyneReceiver(this);
+        }
+        mReceiver->setThreadSettings(mReceiveThread);
+        mReceiver->setSocketSettings(mSocketSettings);
+        if (mReceiver->open(mHost, mPort, mMulticastGroup)) {
+            mReceiver->start();
+            return;
+        }
+        LOG_ERROR("cannot open the " << (IoUringReceiver == mReceiverMode ? "io_uring" : "recvmmsg")
+                  << " receiver, falling back to the Qt socket");
+        delete mReceiver;
+        mReceiver = NULL;
+    }
+
+    initSocket();
+    if (!connect(mSocket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()))) {
+        LOG_ERROR("cannot connect SIGNAL(readyRead()) to SLOT(readPendingDatagrams())");
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
 /// TODO: doc
 void VelodyneComponent::initSocket()
 {
-    if (!(mHost.setAddress(kDefaultHostAddress.c_str()))) {
-        LOG_FATAL("failed to set address");
+    if ((kVelodyneAnyCore != mReceiveThread.core) || (mReceiveThread.priority > 0)) {
+        LOG_WARN("the Qt socket is read in the event loop, properties "
+                 << kPropertyReceiveCore << " and " << kPropertyReceivePriority << " ignored");
     }
-    mPort = kDefaultHostPort;
     mSocket = new QUdpSocket();
     if (!mSocket) {
         LOG_FATAL("cannot create socket");
         return;
     }
-    if (!(mSocket->bind(mHost, mPort))) {
-        LOG_ERROR("error when binding velodyne");
+    if (mMulticastGroup.isNull()) {
+        if (!(mSocket->bind(mHost, mPort))) {
+            LOG_ERROR("error when binding velodyne to " << mHost.toString() << ":" << mPort);
+        }
+    } else {
+        // several components may listen to the same multicast group
+        if (!(mSocket->bind(mHost, mPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))) {
+            LOG_ERROR("error when binding velodyne to " << mHost.toString() << ":" << mPort);
+        } else if (!mSocket->joinMulticastGroup(mMulticastGroup)) {
+            LOG_ERROR("cannot join multicast group " << mMulticastGroup.toString() << ": " << mSocket->errorString());
+        }
+    }
+    if (mSocket->socketDescriptor() >= 0) {
+        tuneSocket((int) mSocket->socketDescriptor(), mSocketSettings);
     }
 }
 
@@ -150,15 +336,60 @@ void VelodyneComponent::stopActivity()
 /// TODO: doc
 void VelodyneComponent::close()
 {
+    if (mReceiver) {
+        mReceiver->stop(kMaxWaitForThreadTimeMs);
+        delete mReceiver;
+        mReceiver = NULL;
+    }
+    if (mPcapReader) {
+        mPcapReader->stop(kMaxWaitForThreadTimeMs);
+        delete mPcapReader;
+        mPcapReader = NULL;
+    }
     closeSocket();
 
-    if (recording) {
-        mVelodyneSphericDataFile.close();
+    if (!wait(kMaxWaitForThreadTimeMs)) {
+        terminate();
+        LOG_ERROR("assembly thread was blocking. It has been terminated");
+    }
+
+    mSectorStreamer.close();
+
+    if (mRecorder) {
+        // the recorder gives back its buffers to the pool once all is written
+        mRecorder->close();
+        delete mRecorder;
+        mRecorder = NULL;
     }
 
-    if (mShMem) {
-        delete mShMem;
-        mShMem = NULL;
+    if (mPacketRecorder) {
+        mPacketRecorder->close();
+        delete mPacketRecorder;
+        mPacketRecorder = NULL;
+    }
+
+    if (mScanPool) {
+        if (mScanPool->exhaustedCount() > 0) {
+            LOG_WARN(mScanPool->exhaustedCount() << " revolutions dropped because all the scan buffers were held");
+        }
+        mScanPool->release(mAssembler.scan());
+        mAssembler.reset(NULL);
+        delete mScanPool;
+        mScanPool = NULL;
+    }
+
+    if (mRing) {
+        LOG_INFO("packet ring: " << mRing->dropCount() << " datagrams dropped"
+                 << ", high-water mark = " << mRing->highWaterMark() << "/" << mRing->capacity());
+        delete mRing;
+        mRing = NULL;
+    }
+
+    mScanRing.close();
+
+    if (mStatisticsShMem) {
+        delete mStatisticsShMem;
+        mStatisticsShMem = NULL;
     }
 }
 
@@ -178,22 +409,239 @@ void VelodyneComponent::closeSocket()
 /// component
 ComponentBase::COMPONENT_CONFIGURATION VelodyneComponent::configureComponent(XmlComponentConfig config)
 {
-    QString recordingParam = param.getProperty(kPropertyRecording.c_str());
-    if (!recordingParam.isNull()) {
-        recording = recordingParam.toInt();
+    bool recordingValue = recording;
+    if (!readBooleanProperty(kPropertyRecording, &recordingValue)) {
+        return ComponentBase::CONFIGURED_FAILED;
     }
-    LOG_INFO("property " << kPropertyRecording << "=\"" << recording << "\"");
-    /*
-    if (!param.getProperty("velodyneIP").isNull()) {
-        host_ = param.getProperty("velodyneIP");
+    recording = recordingValue;
+
+    QString receiverParam = param.getProperty(kPropertyReceiver.c_str());
+    if (!receiverParam.isNull()) {
+        if ("recvmmsg" == receiverParam) {
+            mReceiverMode = RecvmmsgReceiver;
+        } else if ("qt" == receiverParam) {
+            mReceiverMode = QtReceiver;
+        } else if ("pcap" == receiverParam) {
+            mReceiverMode = PcapReceiver;
+        } else if ("iouring" == receiverParam) {
+            mReceiverMode = IoUringReceiver;
+        } else {
+            LOG_ERROR("unknown receiver '" << receiverParam << "', expected 'qt', 'recvmmsg', 'iouring' or 'pcap'");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
     }
-    if (!param.getProperty("velodynePort").isNull()) {
-        port_ = param.getProperty("velodynePort").toInt();
+    LOG_INFO("property " << kPropertyReceiver << "=\""
+             << (RecvmmsgReceiver == mReceiverMode ? "recvmmsg" : PcapReceiver == mReceiverMode ? "pcap"
+                 : IoUringReceiver == mReceiverMode ? "iouring" : "qt") << "\"");
+
+    if (PcapReceiver == mReceiverMode) {
+        QString pcapFileParam = param.getProperty(kPropertyPcapFile.c_str());
+        if (pcapFileParam.isEmpty()) {
+            LOG_ERROR("property " << kPropertyPcapFile << " is needed by the pcap receiver");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+        mPcapFile = pcapFileParam.toStdString();
+        LOG_INFO("property " << kPropertyPcapFile << "=\"" << mPcapFile << "\"");
+
+        QString pcapPacingParam = param.getProperty(kPropertyPcapPacing.c_str());
+        if (!pcapPacingParam.isNull()) {
+            if ("fast" == pcapPacingParam) {
+                mPcapPacing = VelodynePcapReader::FastPacing;
+            } else if ("realtime" == pcapPacingParam) {
+                mPcapPacing = VelodynePcapReader::RealTimePacing;
+            } else {
+                LOG_ERROR("unknown pcap pacing '" << pcapPacingParam << "', expected 'fast' or 'realtime'");
+                return ComponentBase::CONFIGURED_FAILED;
+            }
+        }
+        LOG_INFO("property " << kPropertyPcapPacing << "=\""
+                 << (VelodynePcapReader::FastPacing == mPcapPacing ? "fast" : "realtime") << "\"");
     }
-    */
+
+    QString ringSizeParam = param.getProperty(kPropertyRingSize.c_str());
+    if (!ringSizeParam.isNull()) {
+        mRingSize = ringSizeParam.toInt();
+        if (mRingSize <= 0) {
+            LOG_ERROR("invalid property " << kPropertyRingSize << "=\"" << ringSizeParam << "\"");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property " << kPropertyRingSize << "=\"" << mRingSize << "\"");
+
+    QString scanBufferCountParam = param.getProperty(kPropertyScanBufferCount.c_str());
+    if (!scanBufferCountParam.isNull()) {
+        mScanBufferCount = scanBufferCountParam.toInt();
+        if (mScanBufferCount < 2) {
+            LOG_ERROR("invalid property " << kPropertyScanBufferCount << "=\"" << scanBufferCountParam << "\", at least 2 buffers are needed");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property " << kPropertyScanBufferCount << "=\"" << mScanBufferCount << "\"");
+
+    QString recordQueueSizeParam = param.getProperty(kPropertyRecordQueueSize.c_str());
+    if (!recordQueueSizeParam.isNull()) {
+        mRecordQueueSize = recordQueueSizeParam.toInt();
+        if (mRecordQueueSize <= 0) {
+            LOG_ERROR("invalid property " << kPropertyRecordQueueSize << "=\"" << recordQueueSizeParam << "\"");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    // during a disk stall the assembly holds the revolution being filled and
+    // the writer the one being written, the latest revolution is one of the
+    // queued ones: one more buffer is needed so that acquire() never fails
+    const int maxRecordQueueSize = qMax(1, mScanBufferCount - 3);
+    if (mRecordQueueSize > maxRecordQueueSize) {
+        LOG_WARN("property " << kPropertyRecordQueueSize << "=\"" << mRecordQueueSize << "\" greater than "
+                 << kPropertyScanBufferCount << " - 3, reduced to " << maxRecordQueueSize);
+        mRecordQueueSize = maxRecordQueueSize;
+    }
+    LOG_INFO("property " << kPropertyRecordQueueSize << "=\"" << mRecordQueueSize << "\"");
+
+    QString recordPreallocationParam = param.getProperty(kPropertyRecordPreallocation.c_str());
+    if (!recordPreallocationParam.isNull()) {
+        mRecordPreallocationMB = qMax(0, recordPreallocationParam.toInt());
+    }
+    LOG_INFO("property " << kPropertyRecordPreallocation << "=\"" << mRecordPreallocationMB << "\"");
+
+    QString recordFormatParam = param.getProperty(kPropertyRecordFormat.c_str());
+    if (!recordFormatParam.isNull()) {
+        if ("compact" == recordFormatParam) {
+            mRecordFormat = CompactRecords;
+        } else if ("fixed" == recordFormatParam) {
+            mRecordFormat = FixedRecords;
+        } else if ("packets" == recordFormatParam) {
+            mRecordFormat = PacketRecords;
+        } else {
+            LOG_ERROR("unknown record format '" << recordFormatParam << "', expected 'fixed', 'compact' or 'packets'");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property " << kPropertyRecordFormat << "=\""
+             << (CompactRecords == mRecordFormat ? "compact" : PacketRecords == mRecordFormat ? "packets" : "fixed") << "\"");
+
+    // when only the packets are recorded, the assembly and the shared memory
+    // of the revolutions and of the sectors are skipped by default so that
+    // the recording is as cheap as possible, only the statistics are published
+    mAssembly = !(recording && (PacketRecords == mRecordFormat));
+    if (!readBooleanProperty(kPropertyAssembly, &mAssembly)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+
+    if (recording && (PacketRecords != mRecordFormat) && (mScanBufferCount < 4)) {
+        LOG_ERROR("invalid property " << kPropertyScanBufferCount << "=\"" << mScanBufferCount
+                  << "\", at least 4 buffers are needed to record the revolutions");
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+
+    QString sectorWidthParam = param.getProperty(kPropertySectorWidth.c_str());
+    if (!sectorWidthParam.isNull()) {
+        mSectorWidth = sectorWidthParam.toInt();
+        if ((mSectorWidth < 0) || (mSectorWidth > 360)) {
+            LOG_ERROR("invalid property " << kPropertySectorWidth << "=\"" << sectorWidthParam << "\", expected 0 to 360 degrees");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property " << kPropertySectorWidth << "=\"" << mSectorWidth << "\"");
+
+    QString hostAddressParam = param.getProperty(kPropertyHostAddress.c_str());
+    if (!hostAddressParam.isNull() && !mHost.setAddress(hostAddressParam)) {
+        LOG_ERROR("invalid property " << kPropertyHostAddress << "=\"" << hostAddressParam << "\"");
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+    LOG_INFO("property " << kPropertyHostAddress << "=\"" << mHost.toString() << "\"");
+
+    QString hostPortParam = param.getProperty(kPropertyHostPort.c_str());
+    if (!hostPortParam.isNull()) {
+        int port = hostPortParam.toInt();
+        if ((port <= 0) || (port > 65535)) {
+            LOG_ERROR("invalid property " << kPropertyHostPort << "=\"" << hostPortParam << "\"");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+        mPort = (quint16) port;
+    }
+    LOG_INFO("property " << kPropertyHostPort << "=\"" << mPort << "\"");
+
+    QString multicastGroupParam = param.getProperty(kPropertyMulticastGroup.c_str());
+    if (!multicastGroupParam.isEmpty()) {
+        if (!mMulticastGroup.setAddress(multicastGroupParam)) {
+            LOG_ERROR("invalid property " << kPropertyMulticastGroup << "=\"" << multicastGroupParam << "\"");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+        LOG_INFO("property " << kPropertyMulticastGroup << "=\"" << mMulticastGroup.toString() << "\"");
+    }
+
+    if (!readIntegerProperty(kPropertyReceiveCore, kVelodyneAnyCore, kMaxCore, &mReceiveThread.core)
+            || !readIntegerProperty(kPropertyReceivePriority, 0, 99, &mReceiveThread.priority)
+            || !readIntegerProperty(kPropertyAssemblyCore, kVelodyneAnyCore, kMaxCore, &mAssemblyThread.core)
+            || !readIntegerProperty(kPropertyAssemblyPriority, 0, 99, &mAssemblyThread.priority)
+            || !readIntegerProperty(kPropertyReceiveBufferSize, 0, INT_MAX, &mSocketSettings.receiveBufferSize)
+            || !readIntegerProperty(kPropertyBusyPoll, 0, 1000000, &mSocketSettings.busyPollUs)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+
+    QString sharedMemoryNameParam = param.getProperty(kPropertySharedMemoryName.c_str());
+    if (!sharedMemoryNameParam.isEmpty()) {
+        mSharedMemoryName = sharedMemoryNameParam.toStdString();
+        mSectorSharedMemoryName = mSharedMemoryName + kSectorSharedMemorySuffix;
+    }
+    LOG_INFO("property " << kPropertySharedMemoryName << "=\"" << mSharedMemoryName << "\"");
+    if (!readIntegerProperty(kPropertySharedMemorySlots, 1, kMaxScanRingSlots, &mScanRingSlots)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+
+    if (!readBooleanProperty(kPropertyHugePages, &mMemorySettings.hugePages)
+            || !readBooleanProperty(kPropertyLockMemory, &mMemorySettings.lock)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+
+    QString outputFileParam = param.getProperty(kPropertyOutputFile.c_str());
+    if (!outputFileParam.isEmpty()) {
+        mOutputFilename = outputFileParam.toStdString();
+    }
+    LOG_INFO("property " << kPropertyOutputFile << "=\"" << mOutputFilename << "\"");
     return ComponentBase::CONFIGURED_OK;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// Reads an integer property between min and max. The value is left
+/// unchanged if the property is absent.
+bool VelodyneComponent::readIntegerProperty(const string & name, int min, int max, int * value)
+{
+    QString text = param.getProperty(name.c_str());
+    if (!text.isNull()) {
+        bool ok;
+        int v = text.toInt(&ok);
+        if (!ok || (v < min) || (v > max)) {
+            LOG_ERROR("invalid property " << name << "=\"" << text << "\", expected " << min << " to " << max);
+            return false;
+        }
+        *value = v;
+    }
+    LOG_INFO("property " << name << "=\"" << *value << "\"");
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reads a boolean property, written "1", "true", "0" or "false". The
+/// value is left unchanged if the property is absent.
+bool VelodyneComponent::readBooleanProperty(const string & name, bool * value)
+{
+    QString text = param.getProperty(name.c_str());
+    if (!text.isNull()) {
+        QString word = text.trimmed().toLower();
+        if (("1" == word) || ("true" == word)) {
+            *value = true;
+        } else if (("0" == word) || ("false" == word)) {
+            *value = false;
+        } else {
+            LOG_ERROR("invalid property " << name << "=\"" << text << "\", expected 1, true, 0 or false");
+            return false;
+        }
+    }
+    LOG_INFO("property " << name << "=\"" << (*value ? "true" : "false") << "\"");
+    return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// new data coming from Velodyne sensor
 void VelodyneComponent::readPendingDatagrams() 
@@ -202,197 +650,174 @@ void VelodyneComponent::readPendingDatagrams()
     road_time_t t = road_time();
     if (mRunning) {
         while (mSocket->hasPendingDatagrams()) {
-            QByteArray datagram;
-            datagram.resize(mSocket->pendingDatagramSize());
-            mSocket->readDatagram(datagram.data(), datagram.size(), &mHost, &mPort);
-            processTheDatagram(t, datagram);
-            if (mEndOfScan) {
-                // we have a complete scan of 360° so we can expose it the application
-                exposeData();
-                if (recording) {
-                    record();
-                }
-                mEndOfScan = false;
+            // read directly in the packet ring, or drain the datagram if the ring is full
+            VelodyneDatagram * slot = mRing->reserve();
+            char * buffer = slot ? slot->data : mDatagram;
+            qint64 datagramSize = mSocket->readDatagram(buffer, sizeof(mDatagram));
+            if (datagramSize < 0) {
+                LOG_ERROR("cannot read datagram: " << mSocket->errorString());
+                break;
+            }
+            if (slot) {
+                slot->time = t;
+                slot->size = datagramSize;
+                mRing->commit();
+            } else {
+                mRing->drop(1);
             }
         }
     }
 }
 
 //////////////////////////////////////////////////////////////////////////
-/// TODO: doc
-void VelodyneComponent::processTheDatagram(road_time_t time, QByteArray data)
+/// new batch of datagrams coming from the VelodyneReceiver thread, queued
+/// for the assembly thread
+void VelodyneComponent::processDatagrams(const VelodyneDatagram * datagrams, int count)
 {
-    // envoi des paquets de 1206 octets 12 x 100 + 6
-    // 12 fois :
-    //    2 octets identifiant le bloc laser (haut ou bas)
-    //    2 octets 0 35999, /100 => angle en degré
-    //    96 octets : 32 laser beams, 2 octets distance 0.2 cm increment et 1 octet sur intensité
-    // 6 octets : 0xhhhhDegC : température ou version firmware Vxxx
-
-    const int packetSize = data.size();
-
-    // check the size of the packet
-    if (packetSize != VELODYNE_PACKET_SIZE) {
-        LOG_WARN("strange packet size:"
-                 << " EXPECTED = " << VELODYNE_PACKET_SIZE
-                 << " ACTUAL = " << packetSize
-                 );
-        return;
+    if (mRunning) {
+        mRing->push(datagrams, count);
     }
+}
 
-    // check angle to know if we have done a complete revolution
-    //LOG_TRACE("1st angle of packet = " << firstAngle);
-    LOG_TRACE(data.data());
-    //LOG_TRACE(data.mid(2,2).toHex());
-
-    unsigned short scanCount;
-    int angle;
-    if (!mStartOfScan) {
-        for (int i = 0; i < VELODYNE_NB_BLOCKS_PER_PACKET; ++i) {
-            {
-                bool ok = false;
-                // for each 100 data bytes, we extract the corresponding azimuth angle
-                angle = qFromBigEndian(data.mid(VELODYNE_BLOCK_SIZE*i+2, 2).toHex().toUShort(&ok, 16));
-                scanCount = qFromBigEndian(data.mid(1202, 2).toHex().toUShort(&ok, 16));
-                LOG_TRACE("1:" << "start of scan = " << mStartOfScan << "\t"
-                          << "angle = " << angle << "\t"
-                          << "ok = " << ok << "\t"
-                          << "size = " << packetSize
-                          );
-            }
-            int delta = angle - mPreviousAngle;
-            LOG_TRACE("angle = " << angle);
-            LOG_TRACE("delta = " << delta);
-            LOG_TRACE("#scans = " << scanCount);
-
-            if (delta < 0) {
-                // we are looking for a new revolution
-                mPreviousAngle = angle;
-                mStartOfScan=true;
-                mVelodyneData->time = time;
-
-                int sizeToCopy = packetSize - i*VELODYNE_BLOCK_SIZE - 6;
-                memcpy(&(mVelodyneData->polarData[mBlockIndex]), data.mid(i*VELODYNE_BLOCK_SIZE, sizeToCopy).data(), sizeToCopy);
-
-/* samuel                // Copy the time in each blocks.
-                for (size_t j = 0; j < VELODYNE_NB_BLOCKS_PER_PACKET - i; ++j)
-                  mVelodyneData->dataTime[mBlockIndex + j] = time;
-//*/
-                mBlockIndex += VELODYNE_NB_BLOCKS_PER_PACKET - i;
-                LOG_TRACE("block index = " << mBlockIndex);
-                LOG_TRACE("#scans = " << scanCount);
-                break;
-            } else {
-                mPreviousAngle = angle;
-            }
-        }
-    } else {
-        // start of scan
-        int lastBlockIndex = 0;
-        for (int i = 0; i < VELODYNE_NB_BLOCKS_PER_PACKET; ++i) {
-            {
-                bool ok = false;
-                angle = qFromBigEndian(data.mid(VELODYNE_BLOCK_SIZE*i+2, 2).toHex().toUShort(&ok, 16));
-                scanCount = qFromBigEndian(data.mid(1202, 2).toHex().toUShort(NULL, 16));
-                LOG_TRACE("2:" << "start of scan = " << mStartOfScan << "\t"
-                          << "angle = " << angle << "\t"
-                          << "ok = " << ok << "\t"
-                          << "size = " << packetSize
-                          );
-            }
-            int delta = angle - mPreviousAngle;
-            LOG_TRACE("angle = " << angle);
-            LOG_TRACE("delta = " << delta);
-            LOG_TRACE("#scans = " << scanCount);
-
-            if (delta < 0) {
-                // we are looking for a new revolution
-                LOG_TRACE("block index = " << mBlockIndex);
-                LOG_TRACE("#scans = " << scanCount);
-                //char c;
-                //cin >> c;
-                mEndOfScan = true;
-                // we add +1 because we detect the new revolution in the upper block and we have to copy the lower block too!
-                lastBlockIndex = i+1;
-            }
-            mPreviousAngle = angle;
-        }
-        if (!mEndOfScan) {
-            // we don't reach a complete revolution so only copy bytes in the current buffer
-            memcpy(&(mVelodyneData->polarData[mBlockIndex]), data.data(), VELODYNE_PACKET_SIZE - 6);
-/*samuel            // Copy the time in each blocks.
-            for (size_t j = 0; j < VELODYNE_NB_BLOCKS_PER_PACKET; ++j)
-				mVelodyneData->dataTime[mBlockIndex + j] = time;
-            //*/
-			// Next offset.
-            mBlockIndex += VELODYNE_NB_BLOCKS_PER_PACKET;
-        } else {
-            // we have a complete revolution, we copy the starting data to the current buffer, then switch buffer
-            // and copy the rest of datagram in the new buffer.
-            if (lastBlockIndex > 1) {
-                int sizeToCopy =  packetSize - (VELODYNE_NB_BLOCKS_PER_PACKET - (lastBlockIndex - 1)) * VELODYNE_BLOCK_SIZE  - 6;
-                memcpy(&(mVelodyneData->polarData[mBlockIndex]), data.left(sizeToCopy).data(), sizeToCopy);
-/* samuel                // Copy the time in each blocks.
-                for (size_t j = 0; j < VELODYNE_NB_BLOCKS_PER_PACKET - (lastBlockIndex - 1); ++j)
-                  mVelodyneData->dataTime[mBlockIndex + j] = time;
-            //*/
-			}
-			
-            mVelodyneData->range = mBlockIndex+(lastBlockIndex - 1);
-            LOG_DEBUG("range = " << mVelodyneData->range);
-            mVelodyneData->timerange = time - mVelodyneData->time;
-            mBlockIndex = 0;
-            switchBuffer(); // switch the circular buffer of data. Previous one will be exported later.
-
-            // copy the rest of incoming data in the new buffer
-            mVelodyneData->time = time;
-            int sizeToCopy =  packetSize - (lastBlockIndex - 1)*VELODYNE_BLOCK_SIZE - 6;
-            memcpy(&(mVelodyneData->polarData[mBlockIndex]), data.mid((lastBlockIndex-1) * VELODYNE_BLOCK_SIZE, sizeToCopy).data(), sizeToCopy);
- /* samuel           // Copy the time in each blocks.
-            for (size_t j = 0; j < lastBlockIndex - 1; ++j)
-              mVelodyneData->dataTime[mBlockIndex + j] = time;
- //*/
-            mBlockIndex += sizeToCopy / VELODYNE_BLOCK_SIZE;
+//////////////////////////////////////////////////////////////////////////
+/// Processes one datagram and, when a revolution is complete, exposes
+/// and records it
+void VelodyneComponent::handleDatagram(road_time_t time, const char * data, int packetSize)
+{
+    mAssembler.processDatagram(time, data, packetSize);
+    if (mFullBuffer) {
+        // we have a complete scan of 360° so we can expose it the application
+        exposeData();
+        if (recording) {
+            record();
         }
+        mScanPool->release(mFullBuffer);
+        mFullBuffer = NULL;
     }
 }
 
-/// TODO: doc
+/// Queues the complete revolution for the recorder thread, never waits for the disk
 void VelodyneComponent::record()
 {
     LOG_TRACE("record()");
 
-    //qDebug() << fullBuffer_ << velodyneData_<< &(velodyneDataBuffer_[0]) << &(velodyneDataBuffer_[1]);
-    /*LOG_DEBUG(mFullBuffer->time);
-    LOG_DEBUG(mFullBuffer->timerange);
-    LOG_DEBUG((intptr_t)mFullBuffer);
-    LOG_DEBUG((intptr_t)mVelodyneData);
-    LOG_DEBUG((intptr_t) &(mVelodyneDataBuffer[0]));
-    LOG_DEBUG((intptr_t) &(mVelodyneDataBuffer[1]));*/
-    if (recording) {
-        size_t dataSize = sizeof(VelodynePolarData);
-        mVelodyneSphericDataFile.writeRecord(mFullBuffer->time, mFullBuffer->timerange, (const char *) mFullBuffer, dataSize);
+    if (mRecorder && !mRecorder->enqueue(mFullBuffer)) {
+        LOG_WARN("recording queue full, revolution not recorded");
     }
+}
 
-    LOG_INFO("record succeed");
+/// Called by the assembler: publishes the revolution just completed and
+/// gets a new buffer from the pool for the next one. If all the buffers
+/// are held by consumers, the completed revolution is dropped and its
+/// buffer filled again.
+VelodynePolarData * VelodyneComponent::scanCompleted(VelodynePolarData * scan)
+{
+    // the sectors of a dropped revolution were already streamed, its end is streamed too
+    mSectorStreamer.scanCompleted(scan);
+
+    VelodynePolarData * next = mScanPool->acquire();
+    updateRevolutionStatistics(scan, NULL == next);
+    if (!next) {
+        LOG_WARN("no free scan buffer, revolution dropped");
+        return scan;
+    }
+    mFullBuffer = scan;
+    mScanPool->publish(mFullBuffer);
+    return next;
 }
 
-/// TODO: doc
-void VelodyneComponent::switchBuffer()
+/// Called by the assembler after each packet: streams the azimuth sectors
+/// completed by the new blocks
+void VelodyneComponent::blocksAssembled(const VelodynePolarData * scan, int blockCount, road_time_t time)
 {
-    mFullBuffer = mVelodyneData;
-	/*
-    LOG_DEBUG("full buffer = " << mFullBuffer);
-    LOG_DEBUG("data = " << mVelodyneData);
-    LOG_DEBUG("current data = " << mVelodyneData);*/
-    mCurrentVelodyneData = (mCurrentVelodyneData+1)%2; // a hack to switch between 0 & 1
-    //LOG_DEBUG("current data = " << mVelodyneData);
-    // switch circular buffer
-    mVelodyneData = &(mVelodyneDataBuffer[mCurrentVelodyneData]);
+    mSectorStreamer.blocksAssembled(scan, blockCount, time);
 }
 
-/// TODO: doc
+//////////////////////////////////////////////////////////////////////////
+/// Blocks per revolution and revolution period. The jitter is the running
+/// mean of the deviation of the period from its running mean.
+void VelodyneComponent::updateRevolutionStatistics(const VelodynePolarData * scan, bool dropped)
+{
+    VelodyneStatistics & s = mStatistics;
+    if (dropped) {
+        ++s.droppedRevolutionCount;
+    }
+    ++s.revolutionCount;
+    s.lastRevolutionBlocks = scan->range;
+    if ((1 == s.revolutionCount) || (scan->range < s.minRevolutionBlocks)) {
+        s.minRevolutionBlocks = scan->range;
+    }
+    if (scan->range > s.maxRevolutionBlocks) {
+        s.maxRevolutionBlocks = scan->range;
+    }
+
+    s.lastPeriodUs = scan->timerange;
+    if (1 == s.revolutionCount) {
+        // the first revolution starts anywhere, its period is meaningless
+        return;
+    }
+    if (0 == s.meanPeriodUs) {
+        s.meanPeriodUs = scan->timerange;
+    }
+    const double kWeight = 1.0 / 16;
+    double deviation = scan->timerange - s.meanPeriodUs;
+    s.meanPeriodUs += kWeight * deviation;
+    s.periodJitterUs += kWeight * ((deviation < 0 ? -deviation : deviation) - s.periodJitterUs);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Gathers the counters of the assembly and of the packet ring, computes
+/// the throughput and writes the shared statistics block
+void VelodyneComponent::publishStatistics(road_time_t now)
+{
+    VelodyneStatistics & s = mStatistics;
+    const VelodyneAssemblyCounters & counters = mAssembler.counters();
+    double elapsed = (now - mLastStatisticsTime) / 1e6;
+    s.packetRate = (counters.packetCount - s.packetCount) / elapsed;
+    s.byteRate = (counters.byteCount - s.byteCount) / elapsed;
+    s.packetCount = counters.packetCount;
+    s.byteCount = counters.byteCount;
+    s.malformedPacketCount = counters.malformedPacketCount;
+    s.azimuthGapCount = counters.azimuthGapCount;
+    s.outOfOrderCount = counters.outOfOrderCount;
+    s.overflowBlockCount = counters.overflowBlockCount;
+    s.ringDropCount = mRing->dropCount();
+    s.updateTime = now;
+    mLastStatisticsTime = now;
+
+    if (mStatisticsShMem) {
+        publishVelodyneStatistics(static_cast<VelodyneStatistics *>(mStatisticsShMem->read()), s);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Gives the latest complete revolution without copying it, or NULL if
+/// none is available. The buffer is not reused until releaseScan() is
+/// called, which must happen before the component is stopped.
+const VelodynePolarData * VelodyneComponent::acquireLatestScan()
+{
+    if (!mScanPool) {
+        return NULL;
+    }
+    return mScanPool->acquireLatest();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Gives back a revolution obtained with acquireLatestScan()
+void VelodyneComponent::releaseScan(const VelodynePolarData * scan)
+{
+    mScanPool->release(const_cast<VelodynePolarData *>(scan));
+}
+
+/// Publishes the complete revolution in the ring of the shared memory, only
+/// its valid blocks when the compact format is used
 void VelodyneComponent::exposeData()
 {
-    mShMem->write(mFullBuffer, sizeof(VelodynePolarData) );
+    if (CompactRecords == mRecordFormat) {
+        size_t recordSize;
+        const char * record = VelodyneScanPool::compactRecord(mFullBuffer, &recordSize);
+        mScanRing.publish(record, (int) recordSize);
+    } else {
+        mScanRing.publish(mFullBuffer, sizeof(VelodynePolarData));
+    }
 }
@@ -10,10 +10,22 @@
 #include <qthread.h>
 
 #include "kernel/ComponentBase.h"
-#include "kernel/DbiteFile.h"
 #include "kernel/road_time.h"
 #include "PacpusTools/ShMem.h"
 #include "structure_velodyne.h"
+#include "VelodyneMemory.h"
+#include "VelodynePacketRecorder.h"
+#include "VelodynePacketRing.h"
+#include "VelodynePcapReader.h"
+#include "VelodyneReceiver.h"
+#include "VelodyneRecorder.h"
+#include "VelodyneScanAssembler.h"
+#include "VelodyneScanPool.h"
+#include "VelodyneScanRing.h"
+#include "VelodyneSectorStreamer.h"
+#include "VelodyneStatistics.h"
+#include "VelodyneThreadTuning.h"
+#include "VelodyneUringReceiver.h"
 
 // TODO ! 
 // faire une classe VelodyneDecoding qui s'occupera de traiter les données en provenance du slot readPendingDatagrams
@@ -46,6 +58,8 @@ namespace pacpus {
 class VELODYNEHDL64S2_API VelodyneComponent
         : public QThread
         , public ComponentBase
+        , public VelodynePacketSink
+        , public VelodyneScanSink
 {
     Q_OBJECT
 
@@ -59,6 +73,13 @@ public:
     virtual void startActivity();
     virtual ComponentBase::COMPONENT_CONFIGURATION configureComponent(XmlComponentConfig config);
 
+    /// called in the thread of the VelodyneReceiver
+    void processDatagrams(const VelodyneDatagram * datagrams, int count);
+
+    /// latest complete revolution, held without copy until releaseScan()
+    const VelodynePolarData * acquireLatestScan();
+    void releaseScan(const VelodynePolarData * scan);
+
 public Q_SLOTS:
     void readPendingDatagrams();
 
@@ -68,16 +89,41 @@ protected:
     void initSocket();
     void closeSocket();
     void run();
-    void processTheDatagram(road_time_t time, QByteArray data);
+    void handleDatagram(road_time_t time, const char * data, int packetSize);
     void record();
     void exposeData();
-    void switchBuffer();
+    VelodynePolarData * scanCompleted(VelodynePolarData * scan);
+    bool readIntegerProperty(const std::string & name, int min, int max, int * value);
+    bool readBooleanProperty(const std::string & name, bool * value);
+    void updateRevolutionStatistics(const VelodynePolarData * scan, bool dropped);
+    void publishStatistics(road_time_t now);
+    void blocksAssembled(const VelodynePolarData * scan, int blockCount, road_time_t time);
 
 private:
-    QUdpSocket * mSocket;
+    /// how the UDP stream is read
+    enum ReceiverMode {
+        /// QUdpSocket driven by the Qt event loop
+        QtReceiver,
+        /// VelodyneReceiver thread using recvmmsg()
+        RecvmmsgReceiver,
+        /// VelodynePcapReader thread replaying a capture file
+        PcapReceiver,
+        /// VelodyneUringReceiver thread using an io_uring multishot receive
+        IoUringReceiver
+    };
+    ReceiverMode mReceiverMode;
+    VelodyneReceiver * mReceiver;
+    VelodynePcapReader * mPcapReader;
+    std::string mPcapFile;
+    VelodynePcapReader::Pacing mPcapPacing;
+
+    /// datagrams waiting for the assembly thread
+    VelodynePacketRing * mRing;
+    int mRingSize;
 
-    bool mStartOfScan, mEndOfScan;
-    unsigned short mBlockIndex;
+    QUdpSocket * mSocket;
+    /// datagram drained when the packet ring is full, one byte larger than a packet so that oversized datagrams are detected
+    char mDatagram[VELODYNE_PACKET_SIZE + 1];
 
     /// The Velodyne IP or hostname
     QHostAddress  mHost;
@@ -85,17 +131,63 @@ private:
     /// The Velodyne port
     quint16 mPort;
 
-    struct VelodynePolarData mVelodyneDataBuffer[2];
-    struct VelodynePolarData * mVelodyneData; // a pointer to the current velodyneDataBuffer_
-    struct VelodynePolarData * mFullBuffer;   // a pointer to the velodyne data which is completly filled
-
-    int mCurrentVelodyneData;
-    int mPreviousAngle;
-    bool mRunning;
-
-    DbiteFile mVelodyneSphericDataFile;
-
-    ShMem * mShMem;
+    /// multicast group joined to receive the packets, null when they are sent to mHost
+    QHostAddress mMulticastGroup;
+
+    /// scheduling of the reception and assembly threads
+    VelodyneThreadSettings mReceiveThread;
+    VelodyneThreadSettings mAssemblyThread;
+    /// options of the UDP socket
+    VelodyneSocketSettings mSocketSettings;
+
+    /// names of the shared memory of the revolutions and of the sectors, one per sensor
+    std::string mSharedMemoryName;
+    std::string mSectorSharedMemoryName;
+    /// dbt file of the recording, one per sensor
+    std::string mOutputFilename;
+
+    /// revolution buffers shared with the consumers
+    VelodyneScanPool * mScanPool;
+    int mScanBufferCount;
+    /// fills a buffer of the pool with the packets
+    VelodyneScanAssembler mAssembler;
+    struct VelodynePolarData * mFullBuffer;   // the buffer of the pool which is completly filled, until it is exposed and recorded
+    volatile bool mRunning;
+
+    /// publishes the azimuth sectors before the revolution is complete
+    VelodyneSectorStreamer mSectorStreamer;
+    /// width of the sectors in degrees, 0 when the sectors are not streamed
+    int mSectorWidth;
+
+    /// writes the revolutions in its own thread
+    VelodyneRecorder * mRecorder;
+    int mRecordQueueSize;
+    quint64 mRecordPreallocationMB;
+    /// what is recorded
+    enum RecordFormat {
+        /// whole VelodynePolarData
+        FixedRecords,
+        /// VelodyneCompactScanHeader + packet timings + valid blocks, also used for the shared memory
+        CompactRecords,
+        /// raw packets written by mPacketRecorder instead of the revolutions
+        PacketRecords
+    };
+    RecordFormat mRecordFormat;
+    VelodynePacketRecorder * mPacketRecorder;
+    /// false when the packets are only recorded, without revolution assembly nor shared memory
+    bool mAssembly;
+
+    /// last revolutions, read by any number of consumers
+    VelodyneScanRingWriter mScanRing;
+    int mScanRingSlots;
+    /// backing of the packet ring, the revolution buffers and the shared memory
+    VelodyneMemorySettings mMemorySettings;
+
+    /// counters of the acquisition, updated by the assembly thread
+    VelodyneStatistics mStatistics;
+    /// shared copy of mStatistics, read without lock by VelodyneStatsMonitor
+    ShMem * mStatisticsShMem;
+    road_time_t mLastStatisticsTime;
 };
 
 } // namespace pacpus
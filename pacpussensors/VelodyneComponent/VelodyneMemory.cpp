@@ -0,0 +1,183 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneMemory.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Large buffers of the Velodyne components backed by huge
+//              pages, prefaulted and locked
+//
+*********************************************************************/
+
+#include "VelodyneMemory.h"
+
+#include "kernel/Log.h"
+
+#include <cstdlib>
+
+#ifdef __linux__
+#   include <cerrno>
+#   include <cstring>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneMemory");
+
+#ifdef __linux__
+/// Size of the huge pages of x86-64 and aarch64 with 4 KB pages
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+//////////////////////////////////////////////////////////////////////////
+static inline size_t roundUp(size_t size, size_t unit)
+{
+    return (size + unit - 1) / unit * unit;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void lockMemory(void * address, size_t size)
+{
+    if (0 != mlock(address, size)) {
+        // ENOMEM or EPERM beyond RLIMIT_MEMLOCK without CAP_IPC_LOCK
+        LOG_WARN("cannot lock " << size << " bytes in memory: " << strerror(errno));
+    }
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodyneBuffer::VelodyneBuffer()
+    : mData(NULL)
+    , mSize(0)
+    , mMappedSize(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneBuffer::~VelodyneBuffer()
+{
+    free();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// MAP_POPULATE faults the pages in at once. Transparent huge pages need an
+/// address aligned on 2 MB, so a larger area is mapped and trimmed.
+bool VelodyneBuffer::allocate(size_t size, const VelodyneMemorySettings & settings)
+{
+    free();
+#ifdef __linux__
+    void * data = MAP_FAILED;
+    size_t mappedSize = roundUp(size, settings.hugePages ? kHugePageSize : (size_t) sysconf(_SC_PAGESIZE));
+    if (settings.hugePages) {
+        data = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (MAP_FAILED == data) {
+            LOG_DEBUG("no reserved huge page for " << mappedSize << " bytes, using transparent huge pages");
+            char * area = static_cast<char *>(mmap(NULL, mappedSize + kHugePageSize, PROT_READ | PROT_WRITE,
+                                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (MAP_FAILED != area) {
+                char * aligned = reinterpret_cast<char *>(roundUp(reinterpret_cast<size_t>(area), kHugePageSize));
+                if (aligned > area) {
+                    munmap(area, aligned - area);
+                }
+                munmap(aligned + mappedSize, area + kHugePageSize - aligned);
+                madvise(aligned, mappedSize, MADV_HUGEPAGE);
+                // the pages are faulted in after the advice, so that they are huge ones
+                memset(aligned, 0, mappedSize);
+                data = aligned;
+            }
+        }
+    } else {
+        data = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    }
+    if (MAP_FAILED == data) {
+        LOG_ERROR("cannot map " << mappedSize << " bytes: " << strerror(errno));
+        return false;
+    }
+    if (settings.lock) {
+        lockMemory(data, mappedSize);
+    }
+    mData = data;
+    mMappedSize = mappedSize;
+#else
+    if (settings.hugePages || settings.lock) {
+        LOG_WARN("huge pages and memory locking are only available on Linux");
+    }
+    mData = calloc(1, size);
+    if (!mData) {
+        LOG_ERROR("cannot allocate " << size << " bytes");
+        return false;
+    }
+    mMappedSize = size;
+#endif
+    mSize = size;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneBuffer::free()
+{
+    if (!mData) {
+        return;
+    }
+#ifdef __linux__
+    munmap(mData, mMappedSize);
+#else
+    ::free(mData);
+#endif
+    mData = NULL;
+    mSize = 0;
+    mMappedSize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void * VelodyneBuffer::data() const
+{
+    return mData;
+}
+
+//////////////////////////////////////////////////////////////////////////
+size_t VelodyneBuffer::size() const
+{
+    return mSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// MADV_POPULATE_WRITE faults the pages in without writing them, as a
+/// writer may already use the segment. Before Linux 5.14, a page is read
+/// instead, which also allocates it in a shared memory.
+void pacpus::prepareVelodyneMemory(void * address, size_t size, const VelodyneMemorySettings & settings)
+{
+#ifdef __linux__
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    char * begin = reinterpret_cast<char *>(reinterpret_cast<size_t>(address) / pageSize * pageSize);
+    size_t length = roundUp(static_cast<char *>(address) + size - begin, pageSize);
+
+    if (settings.hugePages && (0 != madvise(begin, length, MADV_HUGEPAGE))) {
+        LOG_WARN("cannot advise huge pages for " << size << " bytes: " << strerror(errno));
+    }
+    if (settings.lock) {
+        // mlock() also faults the pages in
+        lockMemory(begin, length);
+        return;
+    }
+#ifdef MADV_POPULATE_WRITE
+    if (0 == madvise(begin, length, MADV_POPULATE_WRITE)) {
+        return;
+    }
+#endif
+    for (size_t offset = 0; offset < length; offset += pageSize) {
+        (void) *static_cast<volatile char *>(begin + offset);
+    }
+#else
+    (void) address;
+    (void) size;
+    if (settings.hugePages || settings.lock) {
+        LOG_WARN("huge pages and memory locking are only available on Linux");
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+/// @file
+/// Large buffers of the Velodyne components backed by huge pages, prefaulted and locked
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNEMEMORY_H
+#define VELODYNEMEMORY_H
+
+#include <cstddef>
+
+namespace pacpus {
+
+/// Backing of the revolution buffers and shared segments, read from the component XML
+struct VelodyneMemorySettings
+{
+    VelodyneMemorySettings()
+        : hugePages(false)
+        , lock(false)
+    {}
+
+    /// back the buffers with 2 MB pages
+    bool hugePages;
+    /// lock the buffers in memory with mlock()
+    bool lock;
+};
+
+/// Buffer allocated with mmap() instead of new. All its pages are faulted
+/// in at allocation, so that the first revolutions do not pay for it.
+///
+/// With hugePages, the buffer is taken from the 2 MB pages reserved by
+/// vm.nr_hugepages, or else from transparent huge pages. Without mmap(),
+/// on Windows, it falls back to a zeroed heap allocation.
+class VelodyneBuffer
+{
+public:
+    VelodyneBuffer();
+    ~VelodyneBuffer();
+
+    /// Allocates size zeroed bytes, the previous buffer is freed. Returns false if out of memory.
+    bool allocate(size_t size, const VelodyneMemorySettings & settings);
+    void free();
+
+    void * data() const;
+    size_t size() const;
+
+private:
+    VelodyneBuffer(const VelodyneBuffer &);
+    VelodyneBuffer & operator=(const VelodyneBuffer &);
+
+    void * mData;
+    size_t mSize;
+    /// bytes really mapped, a multiple of the page size
+    size_t mMappedSize;
+};
+
+/// Applies the settings to a mapping allocated elsewhere, a ShMem segment:
+/// huge pages are advised, which the kernel only honours for shared memory
+/// when /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it, the
+/// pages are faulted in without changing their content and locked if asked.
+void prepareVelodyneMemory(void * address, size_t size, const VelodyneMemorySettings & settings);
+
+} // namespace pacpus
+
+#endif // VELODYNEMEMORY_H
@@ -0,0 +1,161 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodynePacketRecorder.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Asynchronous recording of the raw Velodyne packets
+//
+*********************************************************************/
+
+#include "VelodynePacketRecorder.h"
+
+#include "kernel/DbiteFileTypes.h"
+#include "kernel/Log.h"
+#include "VelodyneRecorder.h"
+
+#include <cstring>
+
+using namespace pacpus;
+using namespace std;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodynePacketRecorder");
+
+/// Maximal time to wait for the writer thread to stop
+static const unsigned long kMaxWaitForThreadTimeMs = 5000;
+
+/// Time slept by the writer thread when no datagram is queued
+static const unsigned long kWriterIdleSleepMs = 1;
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodynePacketRecorder::VelodynePacketRecorder(int ringSize)
+    : mRing(ringSize)
+    , mRunning(false)
+    , mRecordCount(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodynePacketRecorder::~VelodynePacketRecorder()
+{
+    close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Opens the files and starts the writer thread
+bool VelodynePacketRecorder::open(const string & path, quint64 preallocationBytes)
+{
+    mFile.open(path, WriteMode, VELODYNE_RAW_SPHERIC_DATA, hdfile_header_t::VARIABLE_DATA_SIZE);
+    if (!mFile.isOpen()) {
+        LOG_ERROR("cannot open file '" << path << "'");
+        return false;
+    }
+    string indexPath = path + ".idx";
+    mIndexFile.setFileName(indexPath.c_str());
+    if (!mIndexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        LOG_ERROR("cannot open file '" << indexPath << "': " << mIndexFile.errorString());
+        mFile.close();
+        return false;
+    }
+    if (preallocationBytes > 0) {
+        VelodyneRecorder::preallocate(path, preallocationBytes);
+    }
+
+    mRecordCount = 0;
+    mRunning = true;
+    start();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePacketRecorder::close()
+{
+    if (!mFile.isOpen()) {
+        return;
+    }
+
+    mRunning = false;
+    if (!wait(kMaxWaitForThreadTimeMs)) {
+        terminate();
+        LOG_ERROR("writer thread was blocking. It has been terminated");
+    }
+    mIndexFile.close();
+    mFile.close();
+
+    LOG_INFO("recorded " << recordCount() << " packets"
+             << ", dropped = " << dropCount()
+             << ", max queue depth = " << mRing.highWaterMark() << "/" << mRing.capacity());
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Called by the assembly thread, never waits for the disk
+void VelodynePacketRecorder::enqueue(const VelodyneDatagram * datagrams, int count)
+{
+    if (mRunning) {
+        mRing.push(datagrams, count);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Writer loop, the datagrams still queued are written once stopped
+void VelodynePacketRecorder::run()
+{
+    while (mRunning) {
+        if (0 == writePending()) {
+            QThread::msleep(kWriterIdleSleepMs);
+        }
+    }
+    // the assembly thread no longer queues datagrams, empty the ring
+    int written;
+    do {
+        written = writePending();
+    } while (written > 0);
+    LOG_INFO("ended packet writer thread");
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRecorder::writePending()
+{
+    int count;
+    const VelodyneDatagram * datagrams = mRing.peek(&count);
+    for (int i = 0; i < count; ++i) {
+        write(datagrams[i]);
+    }
+    mRing.release(count);
+    return count;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePacketRecorder::write(const VelodyneDatagram & datagram)
+{
+    int size = qBound(0, datagram.size, (int) sizeof(datagram.data));
+    VelodynePacketRecordHeader * header = reinterpret_cast<VelodynePacketRecordHeader *>(mRecord);
+    header->magic = kVelodynePacketRecordMagic;
+    header->size = size;
+    memcpy(header + 1, datagram.data, size);
+    mFile.writeRecord(datagram.time, 0, mRecord, sizeof(VelodynePacketRecordHeader) + size);
+
+    if (0 == mRecordCount % kPacketIndexInterval) {
+        VelodynePacketIndexEntry entry;
+        entry.time = datagram.time;
+        entry.record = mRecordCount;
+        mIndexFile.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    }
+    ++mRecordCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+quint64 VelodynePacketRecorder::recordCount() const
+{
+    return mRecordCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRecorder::dropCount() const
+{
+    return mRing.dropCount();
+}
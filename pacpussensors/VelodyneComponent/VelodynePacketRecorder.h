@@ -0,0 +1,76 @@
+/// @file
+/// Background writer of the raw Velodyne packets
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNEPACKETRECORDER_H
+#define VELODYNEPACKETRECORDER_H
+
+#include <QFile>
+#include <qthread.h>
+#include <string>
+
+#include "kernel/DbiteFile.h"
+#include "structure_velodyne.h"
+#include "VelodynePacketRing.h"
+#include "VelodyneReceiver.h"
+
+namespace pacpus {
+
+/// Appends the datagrams as received to a dbt file, in its own thread.
+///
+/// Each record is a VelodynePacketRecordHeader followed by the datagram,
+/// stamped with its arrival time: nothing is assembled nor padded. Every
+/// kPacketIndexInterval records, a VelodynePacketIndexEntry is appended to
+/// the sidecar file path + ".idx" so that a time can be found without
+/// reading the packets. The revolutions are rebuilt by
+/// VelodyneScanAssembler, offline or on replay.
+class VelodynePacketRecorder
+        : public QThread
+{
+public:
+    /// ringSize datagrams can wait for the disk
+    explicit VelodynePacketRecorder(int ringSize);
+    ~VelodynePacketRecorder();
+
+    /// Opens the dbt file and its index, reserves preallocationBytes of disk space if not 0
+    bool open(const std::string & path, quint64 preallocationBytes);
+    /// Writes the datagrams still queued, stops the thread and closes the files
+    void close();
+
+    /// Queues datagrams, called by a single thread. The datagrams which do not fit are dropped.
+    void enqueue(const VelodyneDatagram * datagrams, int count);
+
+    /// @name Statistics
+    /// @{
+    quint64 recordCount() const;
+    int dropCount() const;
+    /// @}
+
+    /// number of records between two entries of the time index
+    static const int kPacketIndexInterval = 256;
+
+protected:
+    void run();
+
+private:
+    /// writes the datagrams queued in the ring, returns how many
+    int writePending();
+    void write(const VelodyneDatagram & datagram);
+
+    VelodynePacketRing mRing;
+    DbiteFile mFile;
+    QFile mIndexFile;
+    /// written by close(), read by the writer and the assembly threads
+    volatile bool mRunning;
+    /// only used by the writer thread
+    quint64 mRecordCount;
+    /// record being written, large enough for VelodyneDatagram::data
+    char mRecord[sizeof(VelodynePacketRecordHeader) + VELODYNE_PACKET_SIZE + 1];
+};
+
+} // namespace pacpus
+
+#endif // VELODYNEPACKETRECORDER_H
@@ -0,0 +1,160 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodynePacketRing.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Lock-free ring of datagrams between the socket reader
+//              and the revolution assembly
+//
+*********************************************************************/
+
+#include "VelodynePacketRing.h"
+
+#include <cstring>
+#include <new>
+
+using namespace pacpus;
+
+// The indices are free-running unsigned counters stored in QAtomicInt: the
+// number of datagrams in the ring is always head - tail, even after wrapping.
+// The owner of an index reads it without synchronization, the other side
+// reads it with acquire semantics and the owner publishes it with release
+// semantics, so that the content of a slot is visible before its index.
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor, all the slots are allocated here
+VelodynePacketRing::VelodynePacketRing(int capacity, const VelodyneMemorySettings & memory)
+    : mSlots(NULL)
+    , mMask(0)
+    , mHead(0)
+    , mCachedTail(0)
+    , mDropCount(0)
+    , mTail(0)
+    , mCachedHead(0)
+    , mHighWaterMark(0)
+{
+    unsigned size = 1;
+    while (size < (unsigned) capacity) {
+        size <<= 1;
+    }
+    if (!mSlotBuffer.allocate(size * sizeof(VelodyneDatagram), memory)) {
+        throw std::bad_alloc();
+    }
+    mSlots = static_cast<VelodyneDatagram *>(mSlotBuffer.data());
+    mMask = size - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodynePacketRing::~VelodynePacketRing()
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRing::capacity() const
+{
+    return mMask + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+VelodyneDatagram * VelodynePacketRing::reserve()
+{
+    unsigned head = (int) mHead;
+    if (head - mCachedTail > mMask) {
+        // looks full, get the actual position of the consumer
+        mCachedTail = mTail.fetchAndAddAcquire(0);
+        if (head - mCachedTail > mMask) {
+            return NULL;
+        }
+    }
+    return &mSlots[head & mMask];
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePacketRing::commit()
+{
+    unsigned head = (int) mHead;
+    mHead.fetchAndStoreRelease(head + 1);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRing::push(const VelodyneDatagram * datagrams, int count)
+{
+    unsigned head = (int) mHead;
+    unsigned freeCount = capacity() - (head - mCachedTail);
+    if (freeCount < (unsigned) count) {
+        mCachedTail = mTail.fetchAndAddAcquire(0);
+        freeCount = capacity() - (head - mCachedTail);
+    }
+
+    int stored = qMin((unsigned) count, freeCount);
+    for (int i = 0; i < stored; ++i) {
+        VelodyneDatagram & slot = mSlots[(head + i) & mMask];
+        slot.time = datagrams[i].time;
+        slot.size = datagrams[i].size;
+        memcpy(slot.data, datagrams[i].data, qMin((size_t) qMax(datagrams[i].size, 0), sizeof(slot.data)));
+    }
+    if (stored > 0) {
+        mHead.fetchAndStoreRelease(head + stored);
+    }
+    drop(count - stored);
+    return stored;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePacketRing::drop(int count)
+{
+    if (count > 0) {
+        mDropCount.fetchAndAddRelaxed(count);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+const VelodyneDatagram * VelodynePacketRing::peek(int * count)
+{
+    unsigned tail = (int) mTail;
+    unsigned available = mCachedHead - tail;
+    if (0 == available) {
+        // looks empty, get the actual position of the producer
+        mCachedHead = mHead.fetchAndAddAcquire(0);
+        available = mCachedHead - tail;
+        if ((int) available > (int) mHighWaterMark) {
+            mHighWaterMark = available;
+        }
+    }
+
+    // only return the datagrams before the end of the slots array
+    unsigned contiguous = capacity() - (tail & mMask);
+    *count = qMin(available, contiguous);
+    return &mSlots[tail & mMask];
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePacketRing::release(int count)
+{
+    unsigned tail = (int) mTail;
+    mTail.fetchAndStoreRelease(tail + count);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRing::size() const
+{
+    unsigned head = (int) mHead;
+    unsigned tail = (int) mTail;
+    return head - tail;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRing::highWaterMark() const
+{
+    return mHighWaterMark;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodynePacketRing::dropCount() const
+{
+    return mDropCount;
+}
@@ -0,0 +1,94 @@
+/// @file
+/// Lock-free single-producer/single-consumer ring of Velodyne datagrams
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNEPACKETRING_H
+#define VELODYNEPACKETRING_H
+
+#include <QAtomicInt>
+
+#include "VelodyneMemory.h"
+#include "VelodyneReceiver.h"
+
+namespace pacpus {
+
+/// Bounded ring of datagrams between exactly one producer thread (the
+/// socket reader) and one consumer thread (the revolution assembly).
+///
+/// Neither side ever blocks: when the ring is full the producer drops the
+/// datagram and counts it. The indices of each side live on their own cache
+/// line, together with the copy of the other side's index that the owner
+/// refreshes only when the ring looks full (producer) or empty (consumer).
+/// Each group is surrounded by a full cache line of padding, so that it does
+/// not share a line with the other one whatever the alignment of the ring.
+class VelodynePacketRing
+{
+public:
+    /// capacity is rounded up to a power of two. The slots are allocated as
+    /// told by memory, throws std::bad_alloc if impossible.
+    explicit VelodynePacketRing(int capacity, const VelodyneMemorySettings & memory = VelodyneMemorySettings());
+    ~VelodynePacketRing();
+
+    int capacity() const;
+
+    /// @name Producer side
+    /// @{
+    /// Returns the next free slot, or NULL if the ring is full
+    VelodyneDatagram * reserve();
+    /// Publishes the slot returned by reserve()
+    void commit();
+    /// Copies datagrams in the ring, returns how many were stored; the others are dropped
+    int push(const VelodyneDatagram * datagrams, int count);
+    /// Counts datagrams that were received but could not be stored
+    void drop(int count);
+    /// @}
+
+    /// @name Consumer side
+    /// @{
+    /// Returns the oldest datagrams, count is set to the number of contiguous ones available
+    const VelodyneDatagram * peek(int * count);
+    /// Frees the count oldest datagrams
+    void release(int count);
+    /// @}
+
+    /// @name Statistics, may be read from any thread
+    /// @{
+    /// number of datagrams waiting in the ring
+    int size() const;
+    /// maximal number of datagrams seen waiting by the consumer
+    int highWaterMark() const;
+    /// number of datagrams dropped because the ring was full
+    int dropCount() const;
+    /// @}
+
+private:
+    VelodynePacketRing(const VelodynePacketRing &);
+    VelodynePacketRing & operator=(const VelodynePacketRing &);
+
+    static const int kCacheLineSize = 64;
+
+    VelodyneBuffer mSlotBuffer;
+    VelodyneDatagram * mSlots;
+    unsigned mMask;
+
+    char mPadding0[kCacheLineSize];
+
+    /// written by the producer
+    QAtomicInt mHead;
+    unsigned mCachedTail;
+    QAtomicInt mDropCount;
+    char mPadding1[kCacheLineSize];
+
+    /// written by the consumer
+    QAtomicInt mTail;
+    unsigned mCachedHead;
+    QAtomicInt mHighWaterMark;
+    char mPadding2[kCacheLineSize];
+};
+
+} // namespace pacpus
+
+#endif // VELODYNEPACKETRING_H
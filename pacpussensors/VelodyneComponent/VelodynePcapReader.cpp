@@ -0,0 +1,457 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodynePcapReader.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Replay of a pcap or pcapng capture of the Velodyne
+//              UDP stream
+//
+*********************************************************************/
+
+#include "VelodynePcapReader.h"
+
+#include "kernel/Log.h"
+
+#include <QtEndian>
+#include <cstring>
+
+using namespace pacpus;
+using namespace std;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodynePcapReader");
+
+/// @name Capture file formats
+/// @{
+static const quint32 kPcapMagicMicroseconds = 0xa1b2c3d4;
+static const quint32 kPcapMagicNanoseconds = 0xa1b23c4d;
+static const int kPcapFileHeaderSize = 24;
+static const int kPcapRecordHeaderSize = 16;
+static const quint32 kPcapngSectionHeaderBlock = 0x0a0d0d0a;
+static const quint32 kPcapngByteOrderMagic = 0x1a2b3c4d;
+static const quint32 kPcapngInterfaceDescriptionBlock = 1;
+static const quint32 kPcapngEnhancedPacketBlock = 6;
+static const quint16 kPcapngOptionEnd = 0;
+static const quint16 kPcapngOptionTimestampResolution = 9;
+/// @}
+
+/// @name Link types
+/// @{
+static const int kLinkTypeNull = 0;
+static const int kLinkTypeEthernet = 1;
+static const int kLinkTypeRawOpenBsd = 12;
+static const int kLinkTypeRaw = 101;
+static const int kLinkTypeLinuxCooked = 113;
+static const int kLinkTypeIpv4 = 228;
+/// @}
+
+/// Larger blocks are considered as a corrupted file
+static const int kMaxBlockSize = 256 * 1024;
+
+/// Time slept when the ring is full in FastPacing
+static const unsigned long kRingFullSleepUs = 200;
+
+/// Longest sleep in RealTimePacing, so that a stop request is noticed
+static const road_timerange_t kMaxPacingSleepUs = 100000;
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodynePcapReader::VelodynePcapReader(VelodynePacketRing * ring)
+    : mRing(ring)
+    , mPort(0)
+    , mPacing(RealTimePacing)
+    , mRunning(false)
+    , mPcapng(false)
+    , mBigEndian(false)
+    , mLinkType(kLinkTypeEthernet)
+    , mNanoseconds(false)
+    , mFirstCaptureTime(0)
+    , mFirstQueueTime(0)
+    , mDatagramCount(0)
+    , mSkippedCount(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodynePcapReader::~VelodynePcapReader()
+{
+    close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Opens the capture and reads its header
+bool VelodynePcapReader::open(const string & path, quint16 port, Pacing pacing)
+{
+    mPath = path;
+    mPort = port;
+    mPacing = pacing;
+
+    mFile.setFileName(path.c_str());
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        LOG_ERROR("cannot open file '" << path << "': " << mFile.errorString());
+        return false;
+    }
+    mBlock.resize(kMaxBlockSize);
+    if (!readFileHeader()) {
+        close();
+        return false;
+    }
+    LOG_INFO("replaying the datagrams sent to port " << port
+             << " from the " << (mPcapng ? "pcapng" : "pcap") << " file '" << path << "'"
+             << (FastPacing == mPacing ? " as fast as possible" : " with the original timing"));
+    mRunning = true;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePcapReader::setThreadSettings(const VelodyneThreadSettings & settings)
+{
+    mThreadSettings = settings;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodynePcapReader::close()
+{
+    if (mFile.isOpen()) {
+        mFile.close();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Stops the replay thread
+void VelodynePcapReader::stop(unsigned long timeoutMs)
+{
+    mRunning = false;
+    if (!wait(timeoutMs)) {
+        terminate();
+        LOG_ERROR("pcap reader thread was blocking. It has been terminated");
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Replay loop, it ends at the end of the file
+void VelodynePcapReader::run()
+{
+    tuneCurrentThread("pcap replay", mThreadSettings);
+    mDatagramCount = 0;
+    mSkippedCount = 0;
+    road_time_t start = road_time();
+
+    while (mRunning) {
+        road_time_t captureTime;
+        int frameSize;
+        int linkType;
+        const uchar * frame = nextFrame(&captureTime, &frameSize, &linkType);
+        if (!frame) {
+            break;
+        }
+        int payloadSize;
+        const char * payload = udpPayload(frame, frameSize, linkType, &payloadSize);
+        if (!payload) {
+            ++mSkippedCount;
+            continue;
+        }
+        queue(captureTime, payload, payloadSize);
+    }
+
+    road_timerange_t elapsed = road_time() - start;
+    LOG_INFO("replayed " << mDatagramCount << " datagrams from '" << mPath << "'"
+             << " in " << elapsed / 1000 << " ms"
+             << " (" << (elapsed > 0 ? mDatagramCount * 1000000 / elapsed : 0) << " datagrams/s)"
+             << ", " << mSkippedCount << " other frames skipped");
+    LOG_INFO("ended pcap reader thread");
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reads a 16-bit field in the byte order of the capture file
+quint16 VelodynePcapReader::read16(const uchar * data) const
+{
+    return mBigEndian ? qFromBigEndian<quint16>(data) : qFromLittleEndian<quint16>(data);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reads a 32-bit field in the byte order of the capture file
+quint32 VelodynePcapReader::read32(const uchar * data) const
+{
+    return mBigEndian ? qFromBigEndian<quint32>(data) : qFromLittleEndian<quint32>(data);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Detects the format and the byte order of the file. The pcapng section
+/// header is left to nextPcapngFrame().
+bool VelodynePcapReader::readFileHeader()
+{
+    uchar header[kPcapFileHeaderSize];
+    if (4 != mFile.read((char *) header, 4)) {
+        LOG_ERROR("cannot read the header of '" << mPath << "'");
+        return false;
+    }
+
+    if (kPcapngSectionHeaderBlock == qFromLittleEndian<quint32>(header)) {
+        mPcapng = true;
+        return mFile.seek(0);
+    }
+
+    mPcapng = false;
+    quint32 magic = qFromLittleEndian<quint32>(header);
+    if ((kPcapMagicMicroseconds != magic) && (kPcapMagicNanoseconds != magic)) {
+        magic = qFromBigEndian<quint32>(header);
+        if ((kPcapMagicMicroseconds != magic) && (kPcapMagicNanoseconds != magic)) {
+            LOG_ERROR("'" << mPath << "' is neither a pcap nor a pcapng file");
+            return false;
+        }
+        mBigEndian = true;
+    } else {
+        mBigEndian = false;
+    }
+    mNanoseconds = (kPcapMagicNanoseconds == magic);
+
+    if ((kPcapFileHeaderSize - 4) != mFile.read((char *) header + 4, kPcapFileHeaderSize - 4)) {
+        LOG_ERROR("cannot read the header of '" << mPath << "'");
+        return false;
+    }
+    mLinkType = read32(header + 20);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+const uchar * VelodynePcapReader::nextFrame(road_time_t * captureTime, int * frameSize, int * linkType)
+{
+    if (mPcapng) {
+        return nextPcapngFrame(captureTime, frameSize, linkType);
+    }
+    *linkType = mLinkType;
+    return nextPcapFrame(captureTime, frameSize);
+}
+
+//////////////////////////////////////////////////////////////////////////
+const uchar * VelodynePcapReader::nextPcapFrame(road_time_t * captureTime, int * frameSize)
+{
+    uchar header[kPcapRecordHeaderSize];
+    if (kPcapRecordHeaderSize != mFile.read((char *) header, kPcapRecordHeaderSize)) {
+        return NULL;
+    }
+    quint32 seconds = read32(header);
+    quint32 fraction = read32(header + 4);
+    quint32 capturedSize = read32(header + 8);
+    if (capturedSize > (quint32) kMaxBlockSize) {
+        LOG_ERROR("corrupted record of " << capturedSize << " bytes in '" << mPath << "'");
+        return NULL;
+    }
+    if ((qint64) capturedSize != mFile.read((char *) &mBlock[0], capturedSize)) {
+        return NULL;
+    }
+    *captureTime = (road_time_t) seconds * 1000000 + (mNanoseconds ? fraction / 1000 : fraction);
+    *frameSize = capturedSize;
+    return &mBlock[0];
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reads the pcapng blocks until an enhanced packet block, the others are
+/// only used for the interfaces description
+const uchar * VelodynePcapReader::nextPcapngFrame(road_time_t * captureTime, int * frameSize, int * linkType)
+{
+    forever {
+        uchar header[12];
+        if (8 != mFile.read((char *) header, 8)) {
+            return NULL;
+        }
+        // the type of the section header block reads the same in both byte orders
+        quint32 type = read32(header);
+        int headerSize = 8;
+        if (kPcapngSectionHeaderBlock == type) {
+            if (4 != mFile.read((char *) header + 8, 4)) {
+                return NULL;
+            }
+            if (kPcapngByteOrderMagic == qFromLittleEndian<quint32>(header + 8)) {
+                mBigEndian = false;
+            } else if (kPcapngByteOrderMagic == qFromBigEndian<quint32>(header + 8)) {
+                mBigEndian = true;
+            } else {
+                LOG_ERROR("invalid pcapng section header in '" << mPath << "'");
+                return NULL;
+            }
+            // interfaces are numbered per section
+            mInterfaceLinkTypes.clear();
+            mInterfaceTicksPerSecond.clear();
+            headerSize = 12;
+        }
+
+        quint32 blockSize = read32(header + 4);
+        if ((blockSize < (quint32) headerSize + 4) || (blockSize > (quint32) kMaxBlockSize)) {
+            LOG_ERROR("corrupted pcapng block of " << blockSize << " bytes in '" << mPath << "'");
+            return NULL;
+        }
+        // the body is followed by a copy of the block size
+        int bodySize = blockSize - headerSize;
+        if (bodySize != mFile.read((char *) &mBlock[0], bodySize)) {
+            return NULL;
+        }
+        bodySize -= 4;
+        const uchar * body = &mBlock[0];
+
+        if (kPcapngInterfaceDescriptionBlock == type) {
+            readInterfaceDescription(body, bodySize);
+        } else if (kPcapngEnhancedPacketBlock == type) {
+            if (bodySize < 20) {
+                continue;
+            }
+            quint32 interfaceId = read32(body);
+            quint64 ticks = ((quint64) read32(body + 4) << 32) | read32(body + 8);
+            quint32 capturedSize = read32(body + 12);
+            if ((interfaceId >= mInterfaceLinkTypes.size()) || (capturedSize > (quint32) bodySize - 20)) {
+                continue;
+            }
+            quint64 ticksPerSecond = mInterfaceTicksPerSecond[interfaceId];
+            *captureTime = (ticks / ticksPerSecond) * 1000000 + (ticks % ticksPerSecond) * 1000000 / ticksPerSecond;
+            *frameSize = capturedSize;
+            *linkType = mInterfaceLinkTypes[interfaceId];
+            return body + 20;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Gets the link type and the timestamp resolution of an interface
+void VelodynePcapReader::readInterfaceDescription(const uchar * body, int bodySize)
+{
+    int linkType = -1;
+    quint64 ticksPerSecond = 1000000;
+    if (bodySize >= 8) {
+        linkType = read16(body);
+        int offset = 8;
+        while (offset + 4 <= bodySize) {
+            quint16 code = read16(body + offset);
+            quint16 length = read16(body + offset + 2);
+            offset += 4;
+            if ((kPcapngOptionEnd == code) || (offset + length > bodySize)) {
+                break;
+            }
+            if ((kPcapngOptionTimestampResolution == code) && (length >= 1)) {
+                // power of 10, or of 2 if the most significant bit is set
+                int exponent = body[offset] & 0x7f;
+                if (body[offset] & 0x80) {
+                    ticksPerSecond = (quint64) 1 << qMin(exponent, 63);
+                } else {
+                    ticksPerSecond = 1;
+                    for (int i = 0; i < qMin(exponent, 19); ++i) {
+                        ticksPerSecond *= 10;
+                    }
+                }
+            }
+            // options are padded to 32 bits
+            offset += (length + 3) & ~3;
+        }
+    }
+    mInterfaceLinkTypes.push_back(linkType);
+    mInterfaceTicksPerSecond.push_back(ticksPerSecond);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Goes through the link, IPv4 and UDP headers. Fragmented and truncated
+/// datagrams are ignored, a Velodyne datagram fits in one frame.
+const char * VelodynePcapReader::udpPayload(const uchar * frame, int frameSize, int linkType, int * payloadSize) const
+{
+    int offset;
+    switch (linkType) {
+    case kLinkTypeEthernet: {
+        if (frameSize < 14) {
+            return NULL;
+        }
+        quint16 etherType = qFromBigEndian<quint16>(frame + 12);
+        offset = 14;
+        // 802.1Q and 802.1ad tags
+        while (((0x8100 == etherType) || (0x88a8 == etherType)) && (offset + 4 <= frameSize)) {
+            etherType = qFromBigEndian<quint16>(frame + offset + 2);
+            offset += 4;
+        }
+        if (0x0800 != etherType) {
+            return NULL;
+        }
+        break;
+    }
+    case kLinkTypeLinuxCooked:
+        if ((frameSize < 16) || (0x0800 != qFromBigEndian<quint16>(frame + 14))) {
+            return NULL;
+        }
+        offset = 16;
+        break;
+    case kLinkTypeNull:
+        // address family in the byte order of the capturing machine, AF_INET is 2 everywhere
+        if ((frameSize < 4) || (2 != read32(frame))) {
+            return NULL;
+        }
+        offset = 4;
+        break;
+    case kLinkTypeRawOpenBsd:
+    case kLinkTypeRaw:
+    case kLinkTypeIpv4:
+        offset = 0;
+        break;
+    default:
+        return NULL;
+    }
+
+    const uchar * ip = frame + offset;
+    int ipSize = frameSize - offset;
+    if ((ipSize < 20) || (4 != (ip[0] >> 4)) || (17 != ip[9])) {
+        return NULL;
+    }
+    int ipHeaderSize = (ip[0] & 0x0f) * 4;
+    if ((ipHeaderSize < 20) || (qFromBigEndian<quint16>(ip + 6) & 0x3fff)) {
+        return NULL;
+    }
+    ipSize = qMin(ipSize, (int) qFromBigEndian<quint16>(ip + 2));
+
+    const uchar * udp = ip + ipHeaderSize;
+    int udpSize = ipSize - ipHeaderSize;
+    if ((udpSize < 8) || (mPort != qFromBigEndian<quint16>(udp + 2))) {
+        return NULL;
+    }
+    int udpLength = qFromBigEndian<quint16>(udp + 4);
+    if ((udpLength < 8) || (udpLength > udpSize)) {
+        return NULL;
+    }
+    *payloadSize = udpLength - 8;
+    return (const char *) (udp + 8);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Queues a datagram in the packet ring, after waiting for its time in RealTimePacing
+void VelodynePcapReader::queue(road_time_t captureTime, const char * payload, int payloadSize)
+{
+    road_time_t time = captureTime;
+    if (RealTimePacing == mPacing) {
+        road_time_t now = road_time();
+        if (0 == mDatagramCount) {
+            mFirstCaptureTime = captureTime;
+            mFirstQueueTime = now;
+        } else if (captureTime > mFirstCaptureTime) {
+            road_time_t due = mFirstQueueTime + (captureTime - mFirstCaptureTime);
+            while (mRunning && (now < due)) {
+                QThread::usleep(qMin((road_time_t) kMaxPacingSleepUs, due - now));
+                now = road_time();
+            }
+        }
+        time = now;
+    }
+
+    VelodyneDatagram * slot = mRing->reserve();
+    // the assembly is waited for, nothing is lost when replaying as fast as possible
+    while (!slot && (FastPacing == mPacing) && mRunning) {
+        QThread::usleep(kRingFullSleepUs);
+        slot = mRing->reserve();
+    }
+    if (!slot) {
+        mRing->drop(1);
+        return;
+    }
+    slot->time = time;
+    slot->size = qMin(payloadSize, (int) sizeof(slot->data));
+    memcpy(slot->data, payload, slot->size);
+    mRing->commit();
+    ++mDatagramCount;
+}
@@ -0,0 +1,102 @@
+/// @file
+/// Replay of Velodyne datagrams captured in a pcap or pcapng file
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNEPCAPREADER_H
+#define VELODYNEPCAPREADER_H
+
+#include <QFile>
+#include <qthread.h>
+#include <string>
+#include <vector>
+
+#include "kernel/road_time.h"
+#include "VelodynePacketRing.h"
+#include "VelodyneThreadTuning.h"
+
+namespace pacpus {
+
+/// Reads the UDP datagrams sent to a port from a capture file and queues
+/// them in the packet ring, in place of the network reception.
+///
+/// Both the classic pcap format (microsecond or nanosecond timestamps, any
+/// byte order) and pcapng are read. Ethernet, Linux cooked, raw IP and BSD
+/// loopback link types are supported, IPv4 only.
+class VelodynePcapReader
+        : public QThread
+{
+public:
+    /// how fast the capture is replayed
+    enum Pacing {
+        /// as fast as the assembly consumes the datagrams, none is dropped.
+        /// The datagrams keep the time of their capture.
+        FastPacing,
+        /// with the time intervals of the capture. The datagrams are stamped
+        /// when queued and dropped if the ring is full, as live ones.
+        RealTimePacing
+    };
+
+    explicit VelodynePcapReader(VelodynePacketRing * ring);
+    ~VelodynePcapReader();
+
+    /// Opens the capture file and checks its header, returns false on failure
+    bool open(const std::string & path, quint16 port, Pacing pacing);
+    /// Core and priority applied to the thread when it starts
+    void setThreadSettings(const VelodyneThreadSettings & settings);
+    /// Closes the file, the thread must be stopped
+    void close();
+    /// Stops the thread, waiting at most timeoutMs before terminating it
+    void stop(unsigned long timeoutMs);
+
+protected:
+    void run();
+
+private:
+    bool readFileHeader();
+    /// Reads the next captured frame in mBlock, returns NULL at the end of the file
+    const uchar * nextFrame(road_time_t * captureTime, int * frameSize, int * linkType);
+    const uchar * nextPcapFrame(road_time_t * captureTime, int * frameSize);
+    const uchar * nextPcapngFrame(road_time_t * captureTime, int * frameSize, int * linkType);
+    void readInterfaceDescription(const uchar * body, int bodySize);
+    /// Payload of the frame if it is a UDP datagram sent to mPort, NULL otherwise
+    const char * udpPayload(const uchar * frame, int frameSize, int linkType, int * payloadSize) const;
+    void queue(road_time_t captureTime, const char * payload, int payloadSize);
+
+    quint16 read16(const uchar * data) const;
+    quint32 read32(const uchar * data) const;
+
+    VelodynePacketRing * mRing;
+    QFile mFile;
+    std::string mPath;
+    quint16 mPort;
+    Pacing mPacing;
+    volatile bool mRunning;
+    VelodyneThreadSettings mThreadSettings;
+
+    bool mPcapng;
+    /// byte order of the capture file, which is the one of the machine that wrote it
+    bool mBigEndian;
+    /// classic pcap: link type and timestamp resolution of the file
+    int mLinkType;
+    bool mNanoseconds;
+    /// pcapng: link type and timestamp resolution of each interface of the section
+    std::vector<int> mInterfaceLinkTypes;
+    std::vector<quint64> mInterfaceTicksPerSecond;
+
+    /// frame or pcapng block being read
+    std::vector<uchar> mBlock;
+
+    /// RealTimePacing: capture time of the first datagram and when it was queued
+    road_time_t mFirstCaptureTime;
+    road_time_t mFirstQueueTime;
+
+    quint64 mDatagramCount;
+    quint64 mSkippedCount;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNEPCAPREADER_H
@@ -0,0 +1,229 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneReceiver.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Batched reception of the Velodyne UDP stream in a
+//              dedicated thread
+//
+*********************************************************************/
+
+#include "VelodyneReceiver.h"
+
+#include "kernel/Log.h"
+
+#ifdef __linux__
+#   include <arpa/inet.h>
+#   include <cerrno>
+#   include <cstring>
+#   include <netinet/in.h>
+#   include <sys/socket.h>
+#   include <sys/time.h>
+#   include <unistd.h>
+#endif
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneReceiver");
+
+/// Period at which the reception loop checks if it has to stop
+static const int kReceiveTimeoutMs = 100;
+
+#ifdef __linux__
+/// Ancillary data of a message, large enough for its SCM_TIMESTAMPNS
+static const size_t kControlSize = CMSG_SPACE(sizeof(timespec));
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor, the reception pool is allocated once here
+VelodyneReceiver::VelodyneReceiver(VelodynePacketSink * sink)
+    : mSink(sink)
+    , mSocket(-1)
+    , mRunning(false)
+    , mMessages(NULL)
+    , mVectors(NULL)
+    , mControls(NULL)
+{
+#ifdef __linux__
+    mMessages = new mmsghdr[kBatchSize];
+    mVectors = new iovec[kBatchSize];
+    mControls = new char[kBatchSize * kControlSize];
+    memset(mMessages, 0, kBatchSize * sizeof(mmsghdr));
+    for (int i = 0; i < kBatchSize; ++i) {
+        mVectors[i].iov_base = mDatagrams[i].data;
+        mVectors[i].iov_len = sizeof(mDatagrams[i].data);
+        mMessages[i].msg_hdr.msg_iov = &mVectors[i];
+        mMessages[i].msg_hdr.msg_iovlen = 1;
+        mMessages[i].msg_hdr.msg_control = mControls + i * kControlSize;
+        mMessages[i].msg_hdr.msg_controllen = kControlSize;
+    }
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneReceiver::~VelodyneReceiver()
+{
+    close();
+#ifdef __linux__
+    delete[] mMessages;
+    delete[] mVectors;
+    delete[] mControls;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Opens the UDP socket and binds it to the given address
+bool VelodyneReceiver::open(const QHostAddress & host, quint16 port, const QHostAddress & multicastGroup)
+{
+#ifdef __linux__
+    mSocket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (mSocket < 0) {
+        LOG_ERROR("cannot create socket: " << strerror(errno));
+        return false;
+    }
+
+    // a timeout lets the reception loop notice a stop request
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = kReceiveTimeoutMs * 1000;
+    if (::setsockopt(mSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        LOG_WARN("cannot set receive timeout: " << strerror(errno));
+    }
+    tuneSocket(mSocket, mSocketSettings);
+
+    // reception time of each datagram, given in the ancillary data
+    int timestamp = 1;
+    if (::setsockopt(mSocket, SOL_SOCKET, SO_TIMESTAMPNS, &timestamp, sizeof(timestamp)) < 0) {
+        LOG_WARN("cannot get the reception time of the datagrams, the datagrams of a batch get the same time: "
+                 << strerror(errno));
+    }
+
+    // several components may listen to the same multicast group
+    int reuse = 1;
+    if (!multicastGroup.isNull() && (::setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0)) {
+        LOG_WARN("cannot reuse address: " << strerror(errno));
+    }
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(host.toIPv4Address());
+    if (::bind(mSocket, (sockaddr *) &address, sizeof(address)) < 0) {
+        LOG_ERROR("error when binding velodyne to " << host.toString() << ":" << port
+                  << ": " << strerror(errno));
+        close();
+        return false;
+    }
+    if (!multicastGroup.isNull()) {
+        ip_mreq membership;
+        memset(&membership, 0, sizeof(membership));
+        membership.imr_multiaddr.s_addr = htonl(multicastGroup.toIPv4Address());
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (::setsockopt(mSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+            LOG_ERROR("cannot join multicast group " << multicastGroup.toString() << ": " << strerror(errno));
+            close();
+            return false;
+        }
+        LOG_INFO("joined multicast group " << multicastGroup.toString());
+    }
+    LOG_INFO("receiving Velodyne datagrams on " << host.toString() << ":" << port
+             << " by batches of " << kBatchSize);
+    mRunning = true;
+    return true;
+#else
+    Q_UNUSED(host);
+    Q_UNUSED(port);
+    Q_UNUSED(multicastGroup);
+    LOG_ERROR("recvmmsg reception is only available on Linux");
+    return false;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneReceiver::setThreadSettings(const VelodyneThreadSettings & settings)
+{
+    mThreadSettings = settings;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneReceiver::setSocketSettings(const VelodyneSocketSettings & settings)
+{
+    mSocketSettings = settings;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Closes the UDP socket
+void VelodyneReceiver::close()
+{
+#ifdef __linux__
+    if (mSocket >= 0) {
+        ::close(mSocket);
+        mSocket = -1;
+    }
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Stops the reception thread
+void VelodyneReceiver::stop(unsigned long timeoutMs)
+{
+    mRunning = false;
+    if (!wait(timeoutMs)) {
+        terminate();
+        LOG_ERROR("reception thread was blocking. It has been terminated");
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reception loop: waits for at least one datagram, then gets all the
+/// datagrams already queued by the kernel in the same system call
+void VelodyneReceiver::run()
+{
+#ifdef __linux__
+    tuneCurrentThread("reception", mThreadSettings);
+    while (mRunning) {
+        int count = ::recvmmsg(mSocket, mMessages, kBatchSize, MSG_WAITFORONE, NULL);
+        if (count < 0) {
+            if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno)) {
+                LOG_ERROR("cannot receive datagrams: " << strerror(errno));
+                QThread::msleep(kReceiveTimeoutMs);
+            }
+            continue;
+        }
+
+        // get a timestamp, for the datagrams without reception time
+        road_time_t t = road_time();
+        for (int i = 0; i < count; ++i) {
+            mDatagrams[i].time = receptionTime(mMessages[i], t);
+            mDatagrams[i].size = mMessages[i].msg_len;
+            // the kernel has set it to the length of the ancillary data received
+            mMessages[i].msg_hdr.msg_controllen = kControlSize;
+        }
+        mSink->processDatagrams(mDatagrams, count);
+    }
+#endif
+    LOG_INFO("ended reception thread");
+}
+
+#ifdef __linux__
+//////////////////////////////////////////////////////////////////////////
+/// Time at which the kernel received the message, in the time base of
+/// road_time(), microseconds since the epoch; defaultTime if not given
+road_time_t VelodyneReceiver::receptionTime(const mmsghdr & message, road_time_t defaultTime)
+{
+    msghdr * header = const_cast<msghdr *>(&message.msg_hdr);
+    for (cmsghdr * control = CMSG_FIRSTHDR(header); NULL != control; control = CMSG_NXTHDR(header, control)) {
+        if ((SOL_SOCKET == control->cmsg_level) && (SCM_TIMESTAMPNS == control->cmsg_type)) {
+            timespec time;
+            memcpy(&time, CMSG_DATA(control), sizeof(time));
+            return (road_time_t) time.tv_sec * 1000000 + time.tv_nsec / 1000;
+        }
+    }
+    return defaultTime;
+}
+#endif
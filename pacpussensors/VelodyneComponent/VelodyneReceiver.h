@@ -0,0 +1,94 @@
+/// @file
+/// Dedicated acquisition thread reading the Velodyne UDP stream in batches
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNERECEIVER_H
+#define VELODYNERECEIVER_H
+
+#include <qhostaddress.h>
+#include <qthread.h>
+
+#include "kernel/road_time.h"
+#include "structure_velodyne.h"
+#include "VelodyneThreadTuning.h"
+
+struct iovec;
+struct mmsghdr;
+
+namespace pacpus {
+
+/// A datagram of the reception pool, with its arrival time
+struct VelodyneDatagram
+{
+    /// reception time, in the time base of road_time()
+    road_time_t time;
+    /// size of the datagram, greater than VELODYNE_PACKET_SIZE if it was truncated
+    int size;
+    /// one byte larger than a packet so that oversized datagrams are detected
+    char data[VELODYNE_PACKET_SIZE + 1];
+};
+
+/// Receives the batches of datagrams read by a VelodyneReceiver.
+/// It is called in the thread of the receiver.
+struct VelodynePacketSink
+{
+    virtual ~VelodynePacketSink() {}
+    virtual void processDatagrams(const VelodyneDatagram * datagrams, int count) = 0;
+};
+
+/// Reads the Velodyne UDP stream in its own thread, without any Qt event loop.
+/// Many datagrams are pulled per system call with recvmmsg() into a pool
+/// allocated once at construction. Each datagram is stamped with the time
+/// the kernel received it (SO_TIMESTAMPNS), or with the time of the system
+/// call when the socket does not give it. Only available on Linux.
+class VelodyneReceiver
+        : public QThread
+{
+public:
+    /// maximal number of datagrams read by one system call
+    static const int kBatchSize = 64;
+
+    VelodyneReceiver(VelodynePacketSink * sink);
+    virtual ~VelodyneReceiver();
+
+    /// Opens and binds the UDP socket, then joins multicastGroup unless it is null.
+    /// Returns false on failure
+    virtual bool open(const QHostAddress & host, quint16 port, const QHostAddress & multicastGroup = QHostAddress());
+    /// Core and priority applied to the thread when it starts
+    void setThreadSettings(const VelodyneThreadSettings & settings);
+    /// Options applied to the socket by open()
+    void setSocketSettings(const VelodyneSocketSettings & settings);
+    /// Closes the socket, the thread must be stopped
+    virtual void close();
+    /// Stops the thread, waiting at most timeoutMs before terminating it
+    void stop(unsigned long timeoutMs);
+
+protected:
+    void run();
+
+    VelodynePacketSink * mSink;
+    int mSocket;
+    volatile bool mRunning;
+    VelodyneThreadSettings mThreadSettings;
+    VelodyneSocketSettings mSocketSettings;
+
+private:
+#ifdef __linux__
+    static road_time_t receptionTime(const struct mmsghdr & message, road_time_t defaultTime);
+#endif
+
+    /// preallocated reception pool
+    VelodyneDatagram mDatagrams[kBatchSize];
+    /// recvmmsg() descriptors pointing in mDatagrams
+    struct mmsghdr * mMessages;
+    struct iovec * mVectors;
+    /// ancillary data of each message, holding its reception time
+    char * mControls;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNERECEIVER_H
@@ -0,0 +1,227 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneRecorder.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Asynchronous recording of the Velodyne revolutions
+//
+*********************************************************************/
+
+#include "VelodyneRecorder.h"
+
+#include "kernel/DbiteFileTypes.h"
+#include "kernel/Log.h"
+
+#ifdef __linux__
+#   include <cerrno>
+#   include <cstring>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace pacpus;
+using namespace std;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneRecorder");
+
+/// Maximal time to wait for the writer thread to stop
+static const unsigned long kMaxWaitForThreadTimeMs = 5000;
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodyneRecorder::VelodyneRecorder(VelodyneScanPool * pool, int queueSize)
+    : mPool(pool)
+    , mCompact(false)
+    , mRunning(false)
+    , mQueue(NULL)
+    , mQueueSize(qMax(queueSize, 1))
+    , mQueueHead(0)
+    , mQueueCount(0)
+    , mRecordCount(0)
+    , mDropCount(0)
+    , mMaxQueueDepth(0)
+    , mMaxWriteLatency(0)
+    , mTotalWriteLatency(0)
+{
+    mQueue = new VelodynePolarData *[mQueueSize];
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneRecorder::~VelodyneRecorder()
+{
+    close();
+    delete[] mQueue;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Opens the file and starts the writer thread
+bool VelodyneRecorder::open(const string & path, bool compact, quint64 preallocationBytes)
+{
+    mCompact = compact;
+    if (mCompact) {
+        mFile.open(path, WriteMode, VELODYNE_RAW_SPHERIC_DATA, hdfile_header_t::VARIABLE_DATA_SIZE);
+    } else {
+        mFile.open(path, WriteMode, VELODYNE_RAW_SPHERIC_DATA, sizeof(VelodynePolarData));
+    }
+    if (!mFile.isOpen()) {
+        LOG_ERROR("cannot open file '" << path << "'");
+        return false;
+    }
+    if (preallocationBytes > 0) {
+        preallocate(path, preallocationBytes);
+    }
+
+    mRunning = true;
+    start();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reserves disk blocks for the file without changing its size, so that
+/// the writes do not have to allocate them while recording
+void VelodyneRecorder::preallocate(const string & path, quint64 bytes)
+{
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_WRONLY);
+    if (fd < 0) {
+        LOG_WARN("cannot preallocate '" << path << "': " << strerror(errno));
+        return;
+    }
+    if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, bytes) < 0) {
+        LOG_WARN("cannot preallocate " << bytes << " bytes for '" << path << "': " << strerror(errno));
+    } else {
+        LOG_INFO("preallocated " << bytes << " bytes for '" << path << "'");
+    }
+    ::close(fd);
+#else
+    Q_UNUSED(bytes);
+    LOG_WARN("file preallocation is only available on Linux, '" << path << "' not preallocated");
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneRecorder::close()
+{
+    if (!mFile.isOpen()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mMutex);
+        mRunning = false;
+        mNotEmpty.wakeOne();
+    }
+    if (!wait(kMaxWaitForThreadTimeMs)) {
+        terminate();
+        LOG_ERROR("writer thread was blocking. It has been terminated");
+    }
+    mFile.close();
+
+    LOG_INFO("recorded " << recordCount() << " revolutions"
+             << ", dropped = " << dropCount()
+             << ", max queue depth = " << maxQueueDepth() << "/" << mQueueSize
+             << ", write latency mean = " << meanWriteLatency() << " us"
+             << ", max = " << maxWriteLatency() << " us");
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Called by the acquisition, only waits for the queue mutex
+bool VelodyneRecorder::enqueue(VelodynePolarData * scan)
+{
+    QMutexLocker locker(&mMutex);
+    if (!mRunning || (mQueueCount == mQueueSize)) {
+        ++mDropCount;
+        return false;
+    }
+    mPool->addRef(scan);
+    mQueue[(mQueueHead + mQueueCount) % mQueueSize] = scan;
+    ++mQueueCount;
+    mMaxQueueDepth = qMax(mMaxQueueDepth, mQueueCount);
+    mNotEmpty.wakeOne();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Writer loop, it ends when stopped and the queue is empty
+void VelodyneRecorder::run()
+{
+    forever {
+        VelodynePolarData * scan;
+        {
+            QMutexLocker locker(&mMutex);
+            while (mRunning && (0 == mQueueCount)) {
+                mNotEmpty.wait(&mMutex);
+            }
+            if (0 == mQueueCount) {
+                break;
+            }
+            scan = mQueue[mQueueHead];
+            mQueueHead = (mQueueHead + 1) % mQueueSize;
+            --mQueueCount;
+        }
+        write(scan);
+        mPool->release(scan);
+    }
+    LOG_INFO("ended writer thread");
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneRecorder::write(VelodynePolarData * scan)
+{
+    road_time_t start = road_time();
+    if (mCompact) {
+        size_t recordSize;
+        const char * record = VelodyneScanPool::compactRecord(scan, &recordSize);
+        mFile.writeRecord(scan->time, scan->timerange, record, recordSize);
+    } else {
+        mFile.writeRecord(scan->time, scan->timerange, (const char *) scan, sizeof(VelodynePolarData));
+    }
+    road_timerange_t latency = road_time() - start;
+
+    QMutexLocker locker(&mMutex);
+    ++mRecordCount;
+    mTotalWriteLatency += latency;
+    mMaxWriteLatency = qMax(mMaxWriteLatency, latency);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneRecorder::recordCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mRecordCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneRecorder::dropCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mDropCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneRecorder::maxQueueDepth() const
+{
+    QMutexLocker locker(&mMutex);
+    return mMaxQueueDepth;
+}
+
+//////////////////////////////////////////////////////////////////////////
+road_timerange_t VelodyneRecorder::maxWriteLatency() const
+{
+    QMutexLocker locker(&mMutex);
+    return mMaxWriteLatency;
+}
+
+//////////////////////////////////////////////////////////////////////////
+road_timerange_t VelodyneRecorder::meanWriteLatency() const
+{
+    QMutexLocker locker(&mMutex);
+    if (0 == mRecordCount) {
+        return 0;
+    }
+    return mTotalWriteLatency / mRecordCount;
+}
@@ -0,0 +1,83 @@
+/// @file
+/// Background writer of the Velodyne revolutions
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNERECORDER_H
+#define VELODYNERECORDER_H
+
+#include <qmutex.h>
+#include <qthread.h>
+#include <qwaitcondition.h>
+#include <string>
+
+#include "kernel/DbiteFile.h"
+#include "kernel/road_time.h"
+#include "VelodyneScanPool.h"
+
+namespace pacpus {
+
+/// Writes the revolutions to a dbt file in its own thread.
+///
+/// The acquisition only queues a reference on a buffer of the VelodyneScanPool:
+/// it never waits for the disk. When the bounded queue is full the revolution
+/// is not recorded and counted as dropped.
+class VelodyneRecorder
+        : public QThread
+{
+public:
+    VelodyneRecorder(VelodyneScanPool * pool, int queueSize);
+    ~VelodyneRecorder();
+
+    /// Opens the dbt file and reserves preallocationBytes of disk space for it if not 0.
+    /// Compact records only hold the packet timings and the valid blocks of each revolution, see VelodyneCompactScanHeader.
+    bool open(const std::string & path, bool compact, quint64 preallocationBytes);
+    /// Writes the revolutions still queued, stops the thread and closes the file
+    void close();
+
+    /// Queues a revolution, returns false if it was dropped because the queue is full
+    bool enqueue(VelodynePolarData * scan);
+
+    /// Reserves disk blocks for an open file without changing its size
+    static void preallocate(const std::string & path, quint64 bytes);
+
+    /// @name Statistics
+    /// @{
+    int recordCount() const;
+    int dropCount() const;
+    int maxQueueDepth() const;
+    road_timerange_t maxWriteLatency() const;
+    road_timerange_t meanWriteLatency() const;
+    /// @}
+
+protected:
+    void run();
+
+private:
+    void write(VelodynePolarData * scan);
+
+    VelodyneScanPool * mPool;
+    DbiteFile mFile;
+    bool mCompact;
+    bool mRunning;
+
+    mutable QMutex mMutex;
+    QWaitCondition mNotEmpty;
+    /// circular queue of revolutions to write
+    VelodynePolarData ** mQueue;
+    int mQueueSize;
+    int mQueueHead;
+    int mQueueCount;
+
+    int mRecordCount;
+    int mDropCount;
+    int mMaxQueueDepth;
+    road_timerange_t mMaxWriteLatency;
+    quint64 mTotalWriteLatency;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNERECORDER_H
@@ -0,0 +1,237 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneScanAssembler.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Assembly of the Velodyne packets into revolutions
+//
+*********************************************************************/
+
+#include "VelodyneScanAssembler.h"
+
+#include "kernel/Log.h"
+
+#include <QtEndian>
+#include <cstring>
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneScanAssembler");
+
+/// A step of the azimuth more than this factor times the mean one is a gap
+static const int kAzimuthGapFactor = 3;
+
+/// A backward step of the azimuth smaller than this is not a wrap around but a reordering
+static const int kAzimuthWrapStep = 18000;
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodyneScanAssembler::VelodyneScanAssembler(VelodyneScanSink * sink)
+    : mSink(sink)
+    , mScan(NULL)
+    , mStartOfScan(false)
+    , mBlockIndex(0)
+    , mPreviousAngle(0)
+    , mMeanAzimuthStep(0)
+{
+    memset(&mCounters, 0, sizeof(mCounters));
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneScanAssembler::reset(VelodynePolarData * scan)
+{
+    mScan = scan;
+    mStartOfScan = false;
+    mBlockIndex = 0;
+    mPreviousAngle = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+VelodynePolarData * VelodyneScanAssembler::scan() const
+{
+    return mScan;
+}
+
+//////////////////////////////////////////////////////////////////////////
+const VelodyneAssemblyCounters & VelodyneScanAssembler::counters() const
+{
+    return mCounters;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Reads a little-endian field of a packet in place, whatever the byte order of the host
+static inline uint16_t fromPacketEndian(const uint16_t & field)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(&field));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Decodes a datagram in place and assembles its blocks into the current revolution.
+/// The datagram is only read through a VelodynePacket view: no allocation is done.
+void VelodyneScanAssembler::processDatagram(road_time_t time, const char * data, int packetSize)
+{
+    // envoi des paquets de 1206 octets 12 x 100 + 6
+    // 12 fois :
+    //    2 octets identifiant le bloc laser (haut ou bas)
+    //    2 octets 0 35999, /100 => angle en degré
+    //    96 octets : 32 laser beams, 2 octets distance 0.2 cm increment et 1 octet sur intensité
+    // 6 octets : 0xhhhhDegC : température ou version firmware Vxxx
+
+    ++mCounters.packetCount;
+    mCounters.byteCount += packetSize;
+
+    // check the size of the packet
+    if (packetSize != VELODYNE_PACKET_SIZE) {
+        ++mCounters.malformedPacketCount;
+        LOG_WARN("strange packet size:"
+                 << " EXPECTED = " << VELODYNE_PACKET_SIZE
+                 << " ACTUAL = " << packetSize
+                 );
+        return;
+    }
+
+    const VelodynePacket * packet = reinterpret_cast<const VelodynePacket *>(data);
+    const uint32_t gpsTimestamp = qFromLittleEndian<quint32>(packet->status);
+    for (int i = 0; i < VELODYNE_NB_BLOCKS_PER_PACKET; ++i) {
+        uint16_t identifier = fromPacketEndian(packet->blocks[i].block);
+        if ((kVelodyneUpperBlock != identifier) && (kVelodyneLowerBlock != identifier)) {
+            ++mCounters.malformedPacketCount;
+            break;
+        }
+    }
+
+    // check angle to know if we have done a complete revolution
+    int angle;
+    if (!mStartOfScan) {
+        for (int i = 0; i < VELODYNE_NB_BLOCKS_PER_PACKET; ++i) {
+            // for each block, we extract the corresponding azimuth angle
+            angle = fromPacketEndian(packet->blocks[i].angle);
+            LOG_TRACE("1:" << "start of scan = " << mStartOfScan << "\t"
+                      << "angle = " << angle
+                      );
+            int delta = angle - mPreviousAngle;
+            LOG_TRACE("delta = " << delta);
+            LOG_TRACE("GPS timestamp = " << gpsTimestamp);
+            checkAzimuthStep(delta);
+
+            if (delta < 0) {
+                // we are looking for a new revolution
+                mPreviousAngle = angle;
+                mStartOfScan=true;
+                mScan->time = time;
+                mScan->packetCount = 0;
+                addPacketTiming(time, gpsTimestamp);
+
+                copyBlocks(&(packet->blocks[i]), VELODYNE_NB_BLOCKS_PER_PACKET - i);
+                LOG_TRACE("block index = " << mBlockIndex);
+                mSink->blocksAssembled(mScan, mBlockIndex, time);
+                break;
+            } else {
+                mPreviousAngle = angle;
+            }
+        }
+    } else {
+        // start of scan
+        bool endOfScan = false;
+        int lastBlockIndex = 0;
+        for (int i = 0; i < VELODYNE_NB_BLOCKS_PER_PACKET; ++i) {
+            angle = fromPacketEndian(packet->blocks[i].angle);
+            LOG_TRACE("2:" << "start of scan = " << mStartOfScan << "\t"
+                      << "angle = " << angle
+                      );
+            int delta = angle - mPreviousAngle;
+            LOG_TRACE("delta = " << delta);
+            LOG_TRACE("GPS timestamp = " << gpsTimestamp);
+            checkAzimuthStep(delta);
+
+            if (delta < 0) {
+                // we are looking for a new revolution
+                LOG_TRACE("block index = " << mBlockIndex);
+                endOfScan = true;
+                // we add +1 because we detect the new revolution in the upper block and we have to copy the lower block too!
+                lastBlockIndex = i+1;
+            }
+            mPreviousAngle = angle;
+        }
+        if (!endOfScan) {
+            // we don't reach a complete revolution so only copy bytes in the current buffer
+            addPacketTiming(time, gpsTimestamp);
+            copyBlocks(packet->blocks, VELODYNE_NB_BLOCKS_PER_PACKET);
+            mSink->blocksAssembled(mScan, mBlockIndex, time);
+        } else {
+            // we have a complete revolution, we copy the starting data to the current buffer, then switch buffer
+            // and copy the rest of datagram in the new buffer.
+            const int firstBlockOfNextScan = lastBlockIndex - 1;
+            if (firstBlockOfNextScan > 0) {
+                addPacketTiming(time, gpsTimestamp);
+                copyBlocks(packet->blocks, firstBlockOfNextScan);
+            }
+
+            mScan->range = mBlockIndex;
+            LOG_DEBUG("range = " << mScan->range);
+            mScan->timerange = time - mScan->time;
+            mBlockIndex = 0;
+            // when the sink gives the same buffer back, it is filled again from the start
+            mScan = mSink->scanCompleted(mScan);
+
+            // copy the rest of incoming data in the new buffer
+            mScan->time = time;
+            mScan->packetCount = 0;
+            addPacketTiming(time, gpsTimestamp);
+            copyBlocks(&(packet->blocks[firstBlockOfNextScan]), VELODYNE_NB_BLOCKS_PER_PACKET - firstBlockOfNextScan);
+            mSink->blocksAssembled(mScan, mBlockIndex, time);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// One entry per packet instead of a time per block: the blocks of a packet
+/// share its timing
+void VelodyneScanAssembler::addPacketTiming(road_time_t time, uint32_t gpsTimestamp)
+{
+    if ((mScan->packetCount >= VELODYNE_MAX_PACKETS_PER_SCAN) || (mBlockIndex >= VELODYNE_SCAN_SIZE)) {
+        // no block of the packet will be kept
+        return;
+    }
+    VelodynePacketTiming & timing = mScan->packetTiming[mScan->packetCount++];
+    timing.firstBlock = mBlockIndex;
+    timing.arrivalOffset = (uint32_t) (time - mScan->time);
+    timing.gpsTimestamp = gpsTimestamp;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The blocks of a revolution which never wraps around, when the sensor
+/// stops spinning for instance, would overflow polarData
+void VelodyneScanAssembler::copyBlocks(const VelodyneBlock * blocks, int count)
+{
+    int room = VELODYNE_SCAN_SIZE - mBlockIndex;
+    if (count > room) {
+        mCounters.overflowBlockCount += count - room;
+        count = room;
+    }
+    memcpy(&(mScan->polarData[mBlockIndex]), blocks, count * VELODYNE_BLOCK_SIZE);
+    mBlockIndex += count;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The upper and lower blocks of a firing share their azimuth, so only the
+/// non-zero steps are compared with the mean one
+void VelodyneScanAssembler::checkAzimuthStep(int delta)
+{
+    if (delta < 0) {
+        if (delta > -kAzimuthWrapStep) {
+            ++mCounters.outOfOrderCount;
+        }
+    } else if (delta > 0) {
+        if ((mMeanAzimuthStep > 0) && (delta > kAzimuthGapFactor * mMeanAzimuthStep)) {
+            ++mCounters.azimuthGapCount;
+        } else if (0 == mMeanAzimuthStep) {
+            mMeanAzimuthStep = delta;
+        } else {
+            mMeanAzimuthStep = (15 * mMeanAzimuthStep + delta + 8) / 16;
+        }
+    }
+}
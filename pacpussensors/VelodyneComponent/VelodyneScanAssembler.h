@@ -0,0 +1,87 @@
+/// @file
+/// Assembly of the Velodyne packets into complete revolutions
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNESCANASSEMBLER_H
+#define VELODYNESCANASSEMBLER_H
+
+#include "kernel/road_time.h"
+#include "structure_velodyne.h"
+
+namespace pacpus {
+
+/// Receives the revolutions completed by a VelodyneScanAssembler
+struct VelodyneScanSink
+{
+    virtual ~VelodyneScanSink() {}
+
+    /// scan holds a complete revolution. Returns the buffer in which the next
+    /// revolution is assembled, scan itself to reuse it.
+    virtual VelodynePolarData * scanCompleted(VelodynePolarData * scan) = 0;
+
+    /// The first blockCount blocks of the revolution being assembled in scan
+    /// are filled, called after each packet. Does nothing by default.
+    virtual void blocksAssembled(const VelodynePolarData * /* scan */, int /* blockCount */, road_time_t /* time */) {}
+};
+
+/// Integrity counters of the packets given to a VelodyneScanAssembler, since its construction
+struct VelodyneAssemblyCounters
+{
+    /// datagrams given to processDatagram()
+    uint64_t packetCount;
+    uint64_t byteCount;
+    /// datagrams of a wrong size, ignored, or holding blocks with an unknown identifier
+    uint64_t malformedPacketCount;
+    /// azimuth steps much larger than the usual one, a packet was lost
+    uint64_t azimuthGapCount;
+    /// azimuths going backward without wrapping around, a packet came out of order
+    uint64_t outOfOrderCount;
+    /// blocks dropped because the revolution already held VELODYNE_SCAN_SIZE blocks
+    uint64_t overflowBlockCount;
+};
+
+/// Copies the blocks of the packets into a VelodynePolarData until the
+/// azimuth wraps around, then hands the revolution to a VelodyneScanSink.
+/// The arrival and GPS time of each packet are kept in packetTiming.
+///
+/// Used by the acquisition on live packets and by the player on recorded ones.
+class VelodyneScanAssembler
+{
+public:
+    explicit VelodyneScanAssembler(VelodyneScanSink * sink);
+
+    /// Starts a new revolution in scan, the current one is discarded
+    void reset(VelodynePolarData * scan);
+    /// Buffer of the revolution being assembled
+    VelodynePolarData * scan() const;
+
+    /// Decodes a datagram in place and assembles its blocks, packets of a wrong size are ignored
+    void processDatagram(road_time_t time, const char * data, int packetSize);
+
+    const VelodyneAssemblyCounters & counters() const;
+
+private:
+    /// Notes that the blocks of the packet start at mBlockIndex in mScan
+    void addPacketTiming(road_time_t time, uint32_t gpsTimestamp);
+    /// Appends blocks to mScan, as many as fit in VELODYNE_SCAN_SIZE
+    void copyBlocks(const VelodyneBlock * blocks, int count);
+    /// Counts the gaps and the backward steps of the azimuth
+    void checkAzimuthStep(int delta);
+
+    VelodyneScanSink * mSink;
+    VelodynePolarData * mScan;
+    bool mStartOfScan;
+    int mBlockIndex;
+    int mPreviousAngle;
+
+    VelodyneAssemblyCounters mCounters;
+    /// running mean of the azimuth step between two firings, in hundredths of degree
+    int mMeanAzimuthStep;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNESCANASSEMBLER_H
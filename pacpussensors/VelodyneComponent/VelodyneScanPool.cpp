@@ -0,0 +1,167 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneScanPool.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Pool of revolution buffers with ownership handoff
+//
+*********************************************************************/
+
+#include "VelodyneScanPool.h"
+
+#include "kernel/Log.h"
+#include "VelodyneCompactScan.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneScanPool");
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor, all the buffers are allocated here
+VelodyneScanPool::VelodyneScanPool(int size, const VelodyneMemorySettings & memory)
+    : mSize(qMax(size, 2))
+    , mSlots(NULL)
+    , mRefCounts(NULL)
+    , mLatest(-1)
+    , mExhaustedCount(0)
+{
+    if (!mSlotBuffer.allocate(mSize * sizeof(Slot), memory)) {
+        throw std::bad_alloc();
+    }
+    mSlots = static_cast<Slot *>(mSlotBuffer.data());
+    mRefCounts = new int[mSize];
+    for (int i = 0; i < mSize; ++i) {
+        mRefCounts[i] = 0;
+    }
+    LOG_DEBUG("allocated " << mSize << " scan buffers of " << sizeof(VelodynePolarData) << " bytes");
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor, no buffer must be held anymore except the latest revolution
+VelodyneScanPool::~VelodyneScanPool()
+{
+    for (int i = 0; i < mSize; ++i) {
+        int expected = (i == mLatest) ? 1 : 0;
+        if (mRefCounts[i] != expected) {
+            LOG_WARN("scan buffer " << i << " still referenced " << mRefCounts[i] - expected << " time(s)");
+        }
+    }
+    delete[] mRefCounts;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneScanPool::size() const
+{
+    return mSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Prefers a buffer that nobody holds. Otherwise the latest revolution is
+/// reclaimed if only the pool holds it, as it will be replaced at the next
+/// publish() anyway.
+VelodynePolarData * VelodyneScanPool::acquire()
+{
+    QMutexLocker locker(&mMutex);
+    for (int i = 0; i < mSize; ++i) {
+        if (0 == mRefCounts[i]) {
+            mRefCounts[i] = 1;
+            return &mSlots[i].scan;
+        }
+    }
+    if ((mLatest >= 0) && (1 == mRefCounts[mLatest])) {
+        VelodynePolarData * scan = &mSlots[mLatest].scan;
+        mLatest = -1;
+        return scan;
+    }
+    ++mExhaustedCount;
+    return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneScanPool::publish(VelodynePolarData * scan)
+{
+    int index = indexOf(scan);
+    int packetCount = qBound(0, (int) scan->packetCount, VELODYNE_MAX_PACKETS_PER_SCAN);
+    char * record = compactHeader(scan, packetCount);
+    VelodyneCompactScanHeader & header = *reinterpret_cast<VelodyneCompactScanHeader *>(record);
+    header.magic = kVelodyneCompactScanMagic;
+    header.range = scan->range;
+    header.time = scan->time;
+    header.timerange = scan->timerange;
+    header.packetCount = (int16_t) packetCount;
+    // about 3.5 KB at most, the blocks stay where the assembly put them
+    memcpy(&header + 1, scan->packetTiming, packetCount * sizeof(VelodynePacketTiming));
+
+    QMutexLocker locker(&mMutex);
+    if (mLatest >= 0) {
+        --mRefCounts[mLatest];
+    }
+    ++mRefCounts[index];
+    mLatest = index;
+}
+
+//////////////////////////////////////////////////////////////////////////
+VelodynePolarData * VelodyneScanPool::acquireLatest()
+{
+    QMutexLocker locker(&mMutex);
+    if (mLatest < 0) {
+        return NULL;
+    }
+    ++mRefCounts[mLatest];
+    return &mSlots[mLatest].scan;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneScanPool::addRef(VelodynePolarData * scan)
+{
+    int index = indexOf(scan);
+    QMutexLocker locker(&mMutex);
+    assert(mRefCounts[index] > 0);
+    ++mRefCounts[index];
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneScanPool::release(VelodynePolarData * scan)
+{
+    int index = indexOf(scan);
+    QMutexLocker locker(&mMutex);
+    assert(mRefCounts[index] > 0);
+    --mRefCounts[index];
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneScanPool::exhaustedCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mExhaustedCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+const char * VelodyneScanPool::compactRecord(const VelodynePolarData * scan, size_t * recordSize)
+{
+    int packetCount = qBound(0, (int) scan->packetCount, VELODYNE_MAX_PACKETS_PER_SCAN);
+    *recordSize = velodyneCompactScanSize(scan->range, packetCount);
+    return compactHeader(const_cast<VelodynePolarData *>(scan), packetCount);
+}
+
+//////////////////////////////////////////////////////////////////////////
+char * VelodyneScanPool::compactHeader(VelodynePolarData * scan, int packetCount)
+{
+    return reinterpret_cast<char *>(scan) - sizeof(VelodyneCompactScanHeader) - packetCount * sizeof(VelodynePacketTiming);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneScanPool::indexOf(const VelodynePolarData * scan) const
+{
+    int index = reinterpret_cast<const Slot *>(reinterpret_cast<const char *>(scan) - offsetof(Slot, scan)) - mSlots;
+    assert((0 <= index) && (index < mSize));
+    return index;
+}
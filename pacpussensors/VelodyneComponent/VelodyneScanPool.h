@@ -0,0 +1,90 @@
+/// @file
+/// Pool of revolution buffers shared between the assembly and the consumers
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNESCANPOOL_H
+#define VELODYNESCANPOOL_H
+
+#include <qmutex.h>
+
+#include "kernel/road_time.h"
+#include "structure_velodyne.h"
+#include "VelodyneMemory.h"
+
+namespace pacpus {
+
+/// Fixed set of VelodynePolarData buffers with reference counting.
+///
+/// The assembly acquires a free buffer, fills it, then publishes it. A
+/// published buffer becomes the latest revolution of the pool, which keeps
+/// a reference on it until a newer one is published. Consumers take their
+/// own reference with addRef() or acquireLatest() and give it back with
+/// release(): a buffer is never reused while somebody holds it, so no copy
+/// is needed to keep a finished revolution.
+///
+/// Each buffer is preceded in memory by room for a VelodyneCompactScanHeader
+/// and the packet timings, that publish() fills right before the blocks, so
+/// that a published revolution is also available as a contiguous compact
+/// record without copying its blocks.
+class VelodyneScanPool
+{
+public:
+    /// Allocates size buffers as told by memory, throws std::bad_alloc if impossible
+    explicit VelodyneScanPool(int size, const VelodyneMemorySettings & memory = VelodyneMemorySettings());
+    ~VelodyneScanPool();
+
+    int size() const;
+
+    /// Returns a free buffer referenced once by the caller, or NULL if all the buffers are held
+    VelodynePolarData * acquire();
+    /// Makes a filled buffer the latest revolution and writes its compact header and packet timings, the caller keeps its reference
+    void publish(VelodynePolarData * scan);
+    /// Returns the latest revolution referenced once by the caller, or NULL if none was published
+    VelodynePolarData * acquireLatest();
+    /// Takes one more reference on a buffer
+    void addRef(VelodynePolarData * scan);
+    /// Gives back a reference, the buffer is free again when no reference is left
+    void release(VelodynePolarData * scan);
+
+    /// Compact record of a published buffer: header followed by its packet timings and its range valid blocks
+    static const char * compactRecord(const VelodynePolarData * scan, size_t * recordSize);
+
+    /// number of acquire() calls that failed because all the buffers were held
+    int exhaustedCount() const;
+
+private:
+    VelodyneScanPool(const VelodyneScanPool &);
+    VelodyneScanPool & operator=(const VelodyneScanPool &);
+
+#pragma pack(push, 1)
+    /// the header and the packet timings are put right before polarData, the
+    /// first member of VelodynePolarData, the header starting farther in
+    /// prefix the more packets there are
+    struct Slot
+    {
+        char prefix[sizeof(VelodyneCompactScanHeader) + VELODYNE_MAX_PACKETS_PER_SCAN * sizeof(VelodynePacketTiming)];
+        VelodynePolarData scan;
+    };
+
+    /// where the compact header of a buffer holding packetCount timings starts
+    static char * compactHeader(VelodynePolarData * scan, int packetCount);
+#pragma pack(pop)
+
+    int indexOf(const VelodynePolarData * scan) const;
+
+    mutable QMutex mMutex;
+    int mSize;
+    VelodyneBuffer mSlotBuffer;
+    Slot * mSlots;
+    int * mRefCounts;
+    /// index of the latest published revolution, -1 if none
+    int mLatest;
+    int mExhaustedCount;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNESCANPOOL_H
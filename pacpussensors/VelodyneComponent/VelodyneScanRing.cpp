@@ -0,0 +1,455 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneScanRing.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Ring of revolution records in shared memory with one
+//              seqlock per slot and a futex to wake up the readers
+//
+*********************************************************************/
+
+#include "VelodyneScanRing.h"
+
+#include "kernel/Log.h"
+#include "PacpusTools/ShMem.h"
+
+#include <QAtomicInt>
+#include <cstddef>
+#include <cstring>
+
+#ifdef __linux__
+#   include <climits>
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#   include <time.h>
+#   include <unistd.h>
+#endif
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneScanRing");
+
+/// Alignment of the slots, so that the seqlock of a slot does not share a cache line with another one
+static const int kCacheLineSize = 64;
+
+//////////////////////////////////////////////////////////////////////////
+static inline int align(int size)
+{
+    return (size + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The counters of the shared memory are accessed through QAtomicInt, which
+/// only holds an int, to get the memory ordering across processes
+static inline QAtomicInt * atomic(int * value)
+{
+    return reinterpret_cast<QAtomicInt *>(value);
+}
+
+#ifdef __linux__
+/// Sleep of a reader between two checks of a ring whose writer has not started yet
+static const unsigned long kUninitializedPollMs = 10;
+
+//////////////////////////////////////////////////////////////////////////
+/// Sleeps while *address is value, at most timeoutUs. The futex is shared
+/// between processes, so FUTEX_PRIVATE_FLAG is not used.
+static inline void futexWait(int * address, int value, road_timerange_t timeoutUs)
+{
+    struct timespec timeout;
+    timeout.tv_sec = timeoutUs / 1000000;
+    timeout.tv_nsec = (timeoutUs % 1000000) * 1000;
+    syscall(SYS_futex, address, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+static inline void futexWakeAll(int * address)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+static inline int slotStride(int slotCapacity)
+{
+    return align(sizeof(VelodyneScanRingSlot) + slotCapacity);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int pacpus::velodyneScanRingSize(int slotCount, int slotCapacity)
+{
+    return align(sizeof(VelodyneScanRingHeader)) + slotCount * slotStride(slotCapacity);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodyneScanRingWriter::VelodyneScanRingWriter()
+    : mShMem(NULL)
+    , mHeader(NULL)
+    , mPublished(0)
+    , mReservedSlot(NULL)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneScanRingWriter::~VelodyneScanRingWriter()
+{
+    close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The magic number is written last, readers ignore the ring until then
+bool VelodyneScanRingWriter::open(const std::string & name, int slotCount, int slotCapacity,
+                                  const VelodyneMemorySettings & memory)
+{
+    if (slotCount < 1) {
+        LOG_ERROR("a scan ring needs at least one slot");
+        return false;
+    }
+    close();
+
+    int size = velodyneScanRingSize(slotCount, slotCapacity);
+    mShMem = new ShMem(name.c_str(), size);
+    mHeader = static_cast<VelodyneScanRingHeader *>(mShMem->read());
+    if (!mHeader) {
+        LOG_ERROR("cannot map shared memory '" << name << "'");
+        close();
+        return false;
+    }
+    prepareVelodyneMemory(mHeader, size, memory);
+
+    atomic(reinterpret_cast<int *>(&mHeader->magic))->fetchAndStoreOrdered(0);
+    mHeader->slotCount = slotCount;
+    mHeader->slotStride = slotStride(slotCapacity);
+    mHeader->slotCapacity = slotCapacity;
+    mHeader->published = 0;
+    mHeader->waiters = 0;
+    mHeader->publishTime = 0;
+    char * slotArea = reinterpret_cast<char *>(mHeader) + align(sizeof(VelodyneScanRingHeader));
+    for (int i = 0; i < slotCount; ++i) {
+        VelodyneScanRingSlot * slot = reinterpret_cast<VelodyneScanRingSlot *>(slotArea + i * mHeader->slotStride);
+        slot->sequence = 0;
+        slot->size = 0;
+    }
+    mPublished = 0;
+    atomic(reinterpret_cast<int *>(&mHeader->magic))->fetchAndStoreOrdered(kVelodyneScanRingMagic);
+
+    LOG_INFO("scan ring '" << name << "': " << slotCount << " slots of " << slotCapacity << " bytes");
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneScanRingWriter::close()
+{
+    if (mShMem) {
+        delete mShMem;
+        mShMem = NULL;
+    }
+    mHeader = NULL;
+    mReservedSlot = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneScanRingWriter::isOpen() const
+{
+    return NULL != mHeader;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneScanRingWriter::publish(const void * record, int size)
+{
+    if (!mHeader) {
+        return false;
+    }
+    if ((size < 0) || (size > mHeader->slotCapacity)) {
+        LOG_ERROR("record of " << size << " bytes larger than a slot of the scan ring");
+        return false;
+    }
+    memcpy(reserve(), record, size);
+    return commit(size);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The sequence of the slot is odd while the record is written, so that a
+/// reader copying the same slot notices it.
+void * VelodyneScanRingWriter::reserve()
+{
+    if (!mHeader) {
+        return NULL;
+    }
+    int scan = mPublished + 1;
+    char * slotArea = reinterpret_cast<char *>(mHeader) + align(sizeof(VelodyneScanRingHeader));
+    mReservedSlot = reinterpret_cast<VelodyneScanRingSlot *>(slotArea + (scan % mHeader->slotCount) * mHeader->slotStride);
+    atomic(&mReservedSlot->sequence)->fetchAndStoreOrdered(2 * scan - 1);
+    return mReservedSlot + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The readers sleeping on the published number are woken up, through the
+/// ShMem event on the platforms without futex.
+bool VelodyneScanRingWriter::commit(int size)
+{
+    if (!mReservedSlot) {
+        return false;
+    }
+    if ((size < 0) || (size > mHeader->slotCapacity)) {
+        LOG_ERROR("record of " << size << " bytes larger than a slot of the scan ring");
+        size = 0;
+    }
+
+    int scan = mPublished + 1;
+    mReservedSlot->size = size;
+    atomic(&mReservedSlot->sequence)->fetchAndStoreRelease(2 * scan);
+    mReservedSlot = NULL;
+
+    mHeader->publishTime = road_time();
+    // ordered with the reading of waiters, which a reader increments before checking published
+    atomic(&mHeader->published)->fetchAndStoreOrdered(scan);
+#ifdef __linux__
+    if (atomic(&mHeader->waiters)->fetchAndAddOrdered(0) > 0) {
+        futexWakeAll(&mHeader->published);
+    }
+#else
+    mShMem->write(&scan, sizeof(scan), offsetof(VelodyneScanRingHeader, published));
+#endif
+    mPublished = scan;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodyneScanRingReader::VelodyneScanRingReader()
+    : mShMem(NULL)
+    , mSlotCount(0)
+    , mSlotCapacity(0)
+    , mPosition(0)
+    , mWakeLatency(-1)
+    , mLayoutMismatch(false)
+    , mAcquiredSlot(NULL)
+    , mAcquiredSequence(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneScanRingReader::~VelodyneScanRingReader()
+{
+    close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneScanRingReader::open(const std::string & name, int slotCount, int slotCapacity,
+                                  const VelodyneMemorySettings & memory)
+{
+    if (slotCount < 1) {
+        LOG_ERROR("a scan ring needs at least one slot");
+        return false;
+    }
+    close();
+    int size = velodyneScanRingSize(slotCount, slotCapacity);
+    mShMem = new ShMem(name.c_str(), size);
+    if (!mShMem->read()) {
+        LOG_ERROR("cannot map shared memory '" << name << "'");
+        close();
+        return false;
+    }
+    prepareVelodyneMemory(mShMem->read(), size, memory);
+    mSlotCount = slotCount;
+    mSlotCapacity = slotCapacity;
+    mPosition = 0;
+    mLayoutMismatch = false;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneScanRingReader::close()
+{
+    if (mShMem) {
+        delete mShMem;
+        mShMem = NULL;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneScanRingReader::wait(unsigned long timeoutMs)
+{
+    return waitForScan(mPosition, timeoutMs);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// A reader declares itself in waiters before checking published, and the
+/// writer checks waiters after changing published: either the reader sees
+/// the new scan, or the writer sees the reader and wakes it up.
+bool VelodyneScanRingReader::waitForScan(int scan, unsigned long timeoutMs)
+{
+    mWakeLatency = -1;
+#ifdef __linux__
+    road_time_t deadline = road_time() + (road_time_t) timeoutMs * 1000;
+    bool slept = false;
+    forever {
+        VelodyneScanRingHeader * ring = header();
+        road_time_t now = road_time();
+        if (ring && (atomic(&ring->published)->fetchAndAddAcquire(0) != scan)) {
+            if (slept) {
+                mWakeLatency = (road_timerange_t) (now - ring->publishTime);
+            }
+            return true;
+        }
+        if (now >= deadline) {
+            return false;
+        }
+        road_timerange_t remainingUs = (road_timerange_t) (deadline - now);
+        if (!ring) {
+            usleep(qMin<road_timerange_t>(remainingUs, kUninitializedPollMs * 1000));
+            continue;
+        }
+        atomic(&ring->waiters)->fetchAndAddOrdered(1);
+        futexWait(&ring->published, scan, remainingUs);
+        atomic(&ring->waiters)->fetchAndAddOrdered(-1);
+        slept = true;
+    }
+#else
+    VelodyneScanRingHeader * ring = header();
+    if (ring && (atomic(&ring->published)->fetchAndAddAcquire(0) != scan)) {
+        return true;
+    }
+    if (!mShMem->wait(timeoutMs)) {
+        return false;
+    }
+    ring = header();
+    if (ring) {
+        mWakeLatency = (road_timerange_t) (road_time() - ring->publishTime);
+    }
+    return true;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+road_timerange_t VelodyneScanRingReader::wakeLatency() const
+{
+    return mWakeLatency;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneScanRingReader::position() const
+{
+    return mPosition;
+}
+
+//////////////////////////////////////////////////////////////////////////
+VelodyneScanRingHeader * VelodyneScanRingReader::header()
+{
+    VelodyneScanRingHeader * header = static_cast<VelodyneScanRingHeader *>(mShMem->read());
+    if (kVelodyneScanRingMagic != (uint32_t) atomic(reinterpret_cast<int *>(&header->magic))->fetchAndAddAcquire(0)) {
+        // the writer has not started yet
+        return NULL;
+    }
+    if ((header->slotCount != mSlotCount) || (header->slotCapacity != mSlotCapacity)) {
+        // called at each poll of the readers, the mismatch is only logged once
+        if (!mLayoutMismatch) {
+            LOG_ERROR("scan ring of " << header->slotCount << " slots of " << header->slotCapacity << " bytes"
+                      << ", expected " << mSlotCount << " slots of " << mSlotCapacity << " bytes");
+            mLayoutMismatch = true;
+        }
+        return NULL;
+    }
+    mLayoutMismatch = false;
+    return header;
+}
+
+//////////////////////////////////////////////////////////////////////////
+VelodyneScanRingSlot * VelodyneScanRingReader::slot(int scan)
+{
+    char * slotArea = static_cast<char *>(mShMem->read()) + align(sizeof(VelodyneScanRingHeader));
+    return reinterpret_cast<VelodyneScanRingSlot *>(slotArea + (scan % mSlotCount) * slotStride(mSlotCapacity));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Only the last slotCount scans are in the ring: a reader which fell
+/// further behind goes on with the oldest one still there. A slot already
+/// overwritten by a newer scan is skipped.
+const void * VelodyneScanRingReader::acquire(bool latest, int * size, int * missed)
+{
+    *missed = 0;
+    mAcquiredSlot = NULL;
+    VelodyneScanRingHeader * ring = header();
+    if (!ring) {
+        return NULL;
+    }
+
+    int published = atomic(&ring->published)->fetchAndAddAcquire(0);
+    if (published < mPosition) {
+        // the writer was restarted
+        LOG_WARN("scan ring restarted by its writer");
+        mPosition = 0;
+    }
+    if (published == mPosition) {
+        return NULL;
+    }
+
+    int scan = latest ? published : mPosition + 1;
+    forever {
+        if (scan > published) {
+            return NULL;
+        }
+        if (scan < published - mSlotCount + 1) {
+            scan = published - mSlotCount + 1;
+        }
+
+        VelodyneScanRingSlot * s = slot(scan);
+        int sequence = atomic(&s->sequence)->fetchAndAddAcquire(0);
+        if (sequence == 2 * scan) {
+            *size = s->size;
+            if ((*size < 0) || (*size > mSlotCapacity)) {
+                LOG_ERROR("corrupted slot of " << *size << " bytes in the scan ring");
+                return NULL;
+            }
+            *missed = scan - mPosition - 1;
+            mPosition = scan;
+            mAcquiredSlot = s;
+            mAcquiredSequence = sequence;
+            return s + 1;
+        }
+        // overwritten meanwhile, a newer scan is in the ring
+        ++scan;
+        published = atomic(&ring->published)->fetchAndAddAcquire(0);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneScanRingReader::release()
+{
+    if (!mAcquiredSlot) {
+        return false;
+    }
+    bool consistent = (atomic(&mAcquiredSlot->sequence)->fetchAndAddOrdered(0) == mAcquiredSequence);
+    mAcquiredSlot = NULL;
+    return consistent;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// A record overwritten during the copy is counted as missed and the
+/// following one is copied instead.
+int VelodyneScanRingReader::read(void * buffer, int capacity, bool latest, int * missed)
+{
+    *missed = 0;
+    int size;
+    int skipped;
+    while (const void * record = acquire(latest, &size, &skipped)) {
+        *missed += skipped;
+        if (size > capacity) {
+            LOG_ERROR("record of " << size << " bytes larger than the buffer of " << capacity << " bytes");
+            release();
+            return 0;
+        }
+        memcpy(buffer, record, size);
+        if (release()) {
+            return size;
+        }
+        ++*missed;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/// @file
+/// Ring of revolution records in shared memory, read by any number of consumers
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNESCANRING_H
+#define VELODYNESCANRING_H
+
+#include <string>
+
+#include "kernel/cstdint.h"
+#include "kernel/road_time.h"
+#include "VelodyneMemory.h"
+
+// VelodyneScanRingHeader::magic, set once the ring is initialized by its writer
+#define kVelodyneScanRingMagic 0x56535232
+// slots of the ring of the VelodyneComponent unless configured otherwise
+#define kVelodyneScanRingDefaultSlots 4
+// highest number of slots accepted by the writers of the ring
+#define kVelodyneScanRingMaxSlots 64
+
+namespace pacpus {
+
+class ShMem;
+
+/// Start of the shared memory, followed by slotCount slots
+struct VelodyneScanRingHeader
+{
+    /// kVelodyneScanRingMagic once the writer has initialized the ring
+    uint32_t magic;
+    int32_t slotCount;
+    /// bytes between two slots
+    int32_t slotStride;
+    /// largest record held by a slot
+    int32_t slotCapacity;
+    /// number of the last complete scan, 0 before the first one.
+    /// On Linux, the readers wait on it with a futex.
+    int published;
+    /// readers sleeping on published, the writer only wakes them up when there are some
+    int waiters;
+    /// time of the last publication, to measure the wake-up latency of the readers
+    road_time_t publishTime;
+};
+
+/// Header of a slot, followed by slotCapacity bytes of record.
+/// Scan n is written in slot n % slotCount.
+struct VelodyneScanRingSlot
+{
+    /// seqlock of the slot: 2n - 1 while scan n is written, 2n once complete
+    int sequence;
+    /// bytes of the record
+    int32_t size;
+};
+
+/// Size of the shared memory of a ring
+int velodyneScanRingSize(int slotCount, int slotCapacity);
+
+/// Writes the records in the ring, the oldest scan is overwritten. There
+/// must be a single writer per ring. It never waits for the readers and
+/// only makes a system call to wake them up when some are sleeping.
+class VelodyneScanRingWriter
+{
+public:
+    VelodyneScanRingWriter();
+    ~VelodyneScanRingWriter();
+
+    /// Creates the shared memory, prepared as told by memory, and initializes the ring
+    bool open(const std::string & name, int slotCount, int slotCapacity,
+              const VelodyneMemorySettings & memory = VelodyneMemorySettings());
+    void close();
+
+    bool isOpen() const;
+
+    /// Copies a record in the next slot and publishes it, records larger than a slot are refused
+    bool publish(const void * record, int size);
+    /// Gives the next slot to fill the record in place, slotCapacity bytes at most.
+    /// The readers ignore the slot until commit().
+    void * reserve();
+    /// Publishes the record of size bytes filled since reserve()
+    bool commit(int size);
+
+private:
+    VelodyneScanRingWriter(const VelodyneScanRingWriter &);
+    VelodyneScanRingWriter & operator=(const VelodyneScanRingWriter &);
+
+    ShMem * mShMem;
+    VelodyneScanRingHeader * mHeader;
+    int mPublished;
+    /// slot given by reserve()
+    VelodyneScanRingSlot * mReservedSlot;
+};
+
+/// Reads the records of a ring independently of the other readers: each
+/// reader keeps its own position and is told how many scans it missed.
+/// A slot is copied optimistically and the copy discarded if the writer
+/// overwrote the slot meanwhile.
+class VelodyneScanRingReader
+{
+public:
+    VelodyneScanRingReader();
+    ~VelodyneScanRingReader();
+
+    /// Opens the shared memory, prepared as told by memory. slotCount and
+    /// slotCapacity must be the ones of the writer.
+    bool open(const std::string & name, int slotCount, int slotCapacity,
+              const VelodyneMemorySettings & memory = VelodyneMemorySettings());
+    void close();
+
+    /// Waits until a scan newer than the last one read is published, returns false on timeout
+    bool wait(unsigned long timeoutMs);
+    /// Waits until the number of the last published scan is not scan any more, returns false on timeout.
+    /// On Linux, all the readers are woken up by a futex within microseconds of the publication.
+    bool waitForScan(int scan, unsigned long timeoutMs);
+    /// Time between the publication and the wake-up of the last wait, -1 if it did not sleep
+    road_timerange_t wakeLatency() const;
+
+    /// Copies the scan following the last one read, or the newest one when
+    /// latest is true. Returns the size of the record, 0 if no new scan is
+    /// available. missed receives the number of scans skipped since the last read.
+    int read(void * buffer, int capacity, bool latest, int * missed);
+
+    /// Gives the record of the next scan in its slot, without copying it,
+    /// or NULL if no new scan is available. The writer may overwrite the
+    /// slot at any time: what was read of the record is only consistent if
+    /// release() then returns true.
+    const void * acquire(bool latest, int * size, int * missed);
+    /// Ends the access to the record given by acquire(). Returns false if
+    /// the writer overtook the reader and overwrote the slot meanwhile.
+    bool release();
+
+    /// number of the last scan read, 0 if none
+    int position() const;
+
+private:
+    VelodyneScanRingReader(const VelodyneScanRingReader &);
+    VelodyneScanRingReader & operator=(const VelodyneScanRingReader &);
+
+    /// ring of the shared memory if its writer initialized it with the expected layout
+    VelodyneScanRingHeader * header();
+    VelodyneScanRingSlot * slot(int scan);
+
+    ShMem * mShMem;
+    int mSlotCount;
+    int mSlotCapacity;
+    int mPosition;
+    road_timerange_t mWakeLatency;
+    /// true once a layout different from the expected one was logged, so that it is logged only once
+    bool mLayoutMismatch;
+    /// slot given by acquire() and its sequence at that time
+    VelodyneScanRingSlot * mAcquiredSlot;
+    int mAcquiredSequence;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNESCANRING_H
@@ -0,0 +1,180 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneSectorStreamer.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Publication of the azimuth sectors of a revolution being
+//              assembled
+//
+*********************************************************************/
+
+#include "VelodyneSectorStreamer.h"
+
+#include "kernel/Log.h"
+#include "PacpusTools/ShMem.h"
+
+#include <QtEndian>
+#include <cstring>
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneSectorStreamer");
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor
+VelodyneSectorStreamer::VelodyneSectorStreamer()
+    : mShMem(NULL)
+    , mRecord(NULL)
+    , mWidth(0)
+    , mRevolutionId(0)
+    , mSectorFirstBlock(0)
+    , mSectorId(-1)
+    , mScannedBlockCount(0)
+    , mSectorCount(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneSectorStreamer::~VelodyneSectorStreamer()
+{
+    close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneSectorStreamer::open(const std::string & sharedMemoryName, int widthDegrees)
+{
+    if ((widthDegrees <= 0) || (widthDegrees > 360)) {
+        LOG_ERROR("invalid sector width " << widthDegrees << ", expected 1 to 360 degrees");
+        return false;
+    }
+    close();
+
+    mShMem = new ShMem(sharedMemoryName.c_str(), VELODYNE_SECTOR_MAX_RECORD_SIZE);
+    mRecord = new char[VELODYNE_SECTOR_MAX_RECORD_SIZE];
+    mWidth = widthDegrees * 100;
+    mRevolutionId = 0;
+    mSectorFirstBlock = 0;
+    mSectorId = -1;
+    mScannedBlockCount = 0;
+    mSectorCount = 0;
+    LOG_INFO("streaming sectors of " << widthDegrees << " degrees in shared memory '" << sharedMemoryName << "'");
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneSectorStreamer::close()
+{
+    if (mShMem) {
+        LOG_INFO(mSectorCount << " sectors of " << mRevolutionId << " revolutions published");
+        delete mShMem;
+        mShMem = NULL;
+    }
+    delete[] mRecord;
+    mRecord = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneSectorStreamer::isOpen() const
+{
+    return NULL != mShMem;
+}
+
+//////////////////////////////////////////////////////////////////////////
+unsigned long VelodyneSectorStreamer::sectorCount() const
+{
+    return mSectorCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneSectorStreamer::blocksAssembled(const VelodynePolarData * scan, int blockCount, road_time_t time)
+{
+    if (!mShMem) {
+        return;
+    }
+    findSectors(scan, blockCount, time);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The blocks copied with the packet that ends the revolution were not
+/// looked at yet: the sectors they complete are published first
+void VelodyneSectorStreamer::scanCompleted(const VelodynePolarData * scan)
+{
+    if (!mShMem) {
+        return;
+    }
+    findSectors(scan, scan->range, scan->time + scan->timerange);
+    publish(scan, scan->range, scan->timerange, kVelodyneLastSector);
+
+    ++mRevolutionId;
+    mSectorFirstBlock = 0;
+    mSectorId = -1;
+    mScannedBlockCount = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The upper and lower blocks of a firing share the same azimuth, so a
+/// sector never separates them
+void VelodyneSectorStreamer::findSectors(const VelodynePolarData * scan, int blockCount, road_time_t time)
+{
+    for (int i = mScannedBlockCount; i < blockCount; ++i) {
+        int angle = qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(&scan->polarData[i].angle));
+        int sectorId = angle / mWidth;
+        if (mSectorId < 0) {
+            mSectorId = sectorId;
+        } else if (sectorId != mSectorId) {
+            publish(scan, i, (road_timerange_t) (time - scan->time), 0);
+            mSectorFirstBlock = i;
+            mSectorId = sectorId;
+        }
+    }
+    if (blockCount > mScannedBlockCount) {
+        mScannedBlockCount = blockCount;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Writes the blocks from mSectorFirstBlock up to endBlock as one record
+void VelodyneSectorStreamer::publish(const VelodynePolarData * scan, int endBlock, road_timerange_t timerange, uint16_t flags)
+{
+    int blockCount = endBlock - mSectorFirstBlock;
+    if (blockCount < 0) {
+        LOG_WARN("invalid sector, blocks " << mSectorFirstBlock << " to " << endBlock);
+        return;
+    }
+
+    VelodyneSectorHeader * header = reinterpret_cast<VelodyneSectorHeader *>(mRecord);
+    header->magic = kVelodyneSectorMagic;
+    header->sectorId = (uint16_t) qMax(mSectorId, 0);
+    header->sectorWidth = (uint16_t) mWidth;
+    header->flags = flags;
+    header->revolutionId = mRevolutionId;
+    header->firstBlock = (int16_t) mSectorFirstBlock;
+    header->blockCount = (int16_t) blockCount;
+    header->time = scan->time;
+    header->timerange = timerange;
+
+    // timings of the packets having blocks in the sector, the first packet may have started in the previous sector
+    int packetCount = qBound(0, (int) scan->packetCount, VELODYNE_MAX_PACKETS_PER_SCAN);
+    int firstPacket = 0;
+    while ((firstPacket + 1 < packetCount) && (scan->packetTiming[firstPacket + 1].firstBlock <= mSectorFirstBlock)) {
+        ++firstPacket;
+    }
+    int endPacket = firstPacket;
+    while ((endPacket < packetCount) && (scan->packetTiming[endPacket].firstBlock < endBlock)) {
+        ++endPacket;
+    }
+    header->packetCount = (int16_t) ((blockCount > 0) ? endPacket - firstPacket : 0);
+    char * timing = mRecord + sizeof(VelodyneSectorHeader);
+    memcpy(timing, &scan->packetTiming[firstPacket], header->packetCount * sizeof(VelodynePacketTiming));
+    char * blocks = timing + header->packetCount * sizeof(VelodynePacketTiming);
+    memcpy(blocks, &scan->polarData[mSectorFirstBlock], blockCount * VELODYNE_BLOCK_SIZE);
+
+    mShMem->write(mRecord, (blocks - mRecord) + blockCount * VELODYNE_BLOCK_SIZE);
+    ++mSectorCount;
+    LOG_TRACE("sector " << header->sectorId << " of revolution " << mRevolutionId
+              << ": blocks " << mSectorFirstBlock << " to " << endBlock);
+}
@@ -0,0 +1,74 @@
+/// @file
+/// Publication of the azimuth sectors of a revolution being assembled
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNESECTORSTREAMER_H
+#define VELODYNESECTORSTREAMER_H
+
+#include "kernel/road_time.h"
+#include "structure_velodyne.h"
+
+#include <string>
+
+namespace pacpus {
+
+class ShMem;
+
+/// Splits the revolution being assembled into azimuth sectors and writes
+/// each sector in a shared memory as soon as a block of the next sector
+/// arrives, so that the consumers do not wait for the whole revolution.
+///
+/// Each record is a VelodyneSectorHeader followed by the timings of the
+/// packets of the sector and by its blocks. The last sector of a revolution is flagged with
+/// kVelodyneLastSector when the revolution completes.
+///
+/// Driven by the assembly thread through the VelodyneScanSink calls.
+class VelodyneSectorStreamer
+{
+public:
+    VelodyneSectorStreamer();
+    ~VelodyneSectorStreamer();
+
+    /// Creates the shared memory, widthDegrees is the azimuth width of a sector
+    bool open(const std::string & sharedMemoryName, int widthDegrees);
+    void close();
+    bool isOpen() const;
+
+    /// Publishes the sectors completed by the first blockCount blocks of scan
+    void blocksAssembled(const VelodynePolarData * scan, int blockCount, road_time_t time);
+    /// Publishes the remaining blocks of a complete revolution as its last sector
+    void scanCompleted(const VelodynePolarData * scan);
+
+    /// number of sectors published since open()
+    unsigned long sectorCount() const;
+
+private:
+    VelodyneSectorStreamer(const VelodyneSectorStreamer &);
+    VelodyneSectorStreamer & operator=(const VelodyneSectorStreamer &);
+
+    /// Finds the sector boundaries in the blocks not yet looked at
+    void findSectors(const VelodynePolarData * scan, int blockCount, road_time_t time);
+    void publish(const VelodynePolarData * scan, int blockCount, road_timerange_t timerange, uint16_t flags);
+
+    ShMem * mShMem;
+    /// header, packet timings and blocks of the record, written in the shared memory at once
+    char * mRecord;
+    /// width of a sector in hundredths of degree
+    int mWidth;
+
+    uint32_t mRevolutionId;
+    /// first block of the sector being filled
+    int mSectorFirstBlock;
+    /// id of the sector being filled, -1 until its first block is known
+    int mSectorId;
+    /// blocks of the revolution already looked at
+    int mScannedBlockCount;
+    unsigned long mSectorCount;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNESECTORSTREAMER_H
@@ -0,0 +1,104 @@
+/// @file
+/// Acquisition statistics of a VelodyneComponent, published in shared memory
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNESTATISTICS_H
+#define VELODYNESTATISTICS_H
+
+#include <QAtomicInt>
+#include <cstddef>
+#include <cstring>
+
+#include "kernel/road_time.h"
+#include "structure_velodyne.h"
+
+// VelodyneStatistics::magic, changed with the layout of the structure
+#define kVelodyneStatisticsMagic 0x56535431
+
+/// appended to the name of the shared memory of the revolutions
+#define VELODYNE_STATISTICS_SUFFIX "_STATS"
+
+namespace pacpus {
+
+/// Counters of a VelodyneComponent, updated several times per second.
+///
+/// The block is written by the assembly thread only. Readers in other
+/// processes take a consistent snapshot without any lock: sequence is odd
+/// while the block is written, and a snapshot is valid when sequence is
+/// even and did not change while the block was copied.
+struct VelodyneStatistics
+{
+    /// odd while the block is written, first member so that the other ones are copied at once
+    int sequence;
+    /// kVelodyneStatisticsMagic once the component has published
+    uint32_t magic;
+    /// time of the last update
+    road_time_t updateTime;
+
+    /// datagrams processed by the assembly and their size, since the start
+    uint64_t packetCount;
+    uint64_t byteCount;
+    /// throughput over the last update period
+    double packetRate;
+    double byteRate;
+    /// datagrams lost because the packet ring was full
+    uint64_t ringDropCount;
+
+    /// datagrams of a wrong size or with an unknown block identifier
+    uint64_t malformedPacketCount;
+    /// azimuth steps much larger than the usual one, a packet was lost
+    uint64_t azimuthGapCount;
+    /// azimuths going backward without wrapping around
+    uint64_t outOfOrderCount;
+    /// blocks dropped because a revolution held more than VELODYNE_SCAN_SIZE blocks
+    uint64_t overflowBlockCount;
+
+    /// complete revolutions, and those dropped because no scan buffer was free
+    uint64_t revolutionCount;
+    uint64_t droppedRevolutionCount;
+    /// blocks of the last revolution, and the extremes since the start
+    int32_t lastRevolutionBlocks;
+    int32_t minRevolutionBlocks;
+    int32_t maxRevolutionBlocks;
+    /// duration of the last revolution in microseconds, its running mean and mean deviation
+    int32_t lastPeriodUs;
+    double meanPeriodUs;
+    double periodJitterUs;
+};
+
+/// Writes statistics in the shared block, called by its only writer
+inline void publishVelodyneStatistics(VelodyneStatistics * shared, const VelodyneStatistics & statistics)
+{
+    QAtomicInt * sequence = reinterpret_cast<QAtomicInt *>(&shared->sequence);
+    sequence->fetchAndAddOrdered(1);
+    memcpy(reinterpret_cast<char *>(shared) + sizeof(shared->sequence),
+           reinterpret_cast<const char *>(&statistics) + sizeof(statistics.sequence),
+           sizeof(VelodyneStatistics) - sizeof(statistics.sequence));
+    sequence->fetchAndAddOrdered(1);
+}
+
+/// Copies a consistent snapshot of the shared block, without blocking its
+/// writer. Returns false if no consistent copy was obtained after a few tries.
+inline bool readVelodyneStatistics(VelodyneStatistics * shared, VelodyneStatistics * snapshot)
+{
+    QAtomicInt * sequence = reinterpret_cast<QAtomicInt *>(&shared->sequence);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int before = sequence->fetchAndAddOrdered(0);
+        if (before & 1) {
+            continue;
+        }
+        memcpy(snapshot, shared, sizeof(VelodyneStatistics));
+        if (sequence->fetchAndAddOrdered(0) == before) {
+            snapshot->sequence = before;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace pacpus
+
+#endif // VELODYNESTATISTICS_H
@@ -0,0 +1,144 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneThreadTuning.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Scheduling of the Velodyne acquisition threads and tuning
+//              of their sockets
+//
+*********************************************************************/
+
+#include "VelodyneThreadTuning.h"
+
+#include "kernel/Log.h"
+
+#ifdef __linux__
+#   include <cerrno>
+#   include <cstring>
+#   include <pthread.h>
+#   include <sched.h>
+#   include <sys/socket.h>
+#endif
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneThreadTuning");
+
+//////////////////////////////////////////////////////////////////////////
+/// The core and the policy are read back from the system so that the log
+/// shows what is really in effect
+bool pacpus::tuneCurrentThread(const char * threadName, const VelodyneThreadSettings & settings)
+{
+#ifdef __linux__
+    bool ok = true;
+    pthread_t thread = pthread_self();
+
+    if (kVelodyneAnyCore != settings.core) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(settings.core, &cpus);
+        int error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+        if (0 != error) {
+            LOG_ERROR(threadName << " thread: cannot pin on core " << settings.core << ": " << strerror(error));
+            ok = false;
+        }
+    }
+
+    if (settings.priority > 0) {
+        sched_param parameters;
+        memset(&parameters, 0, sizeof(parameters));
+        parameters.sched_priority = settings.priority;
+        int error = pthread_setschedparam(thread, SCHED_FIFO, &parameters);
+        if (0 != error) {
+            // EPERM without CAP_SYS_NICE or a sufficient RLIMIT_RTPRIO
+            LOG_ERROR(threadName << " thread: cannot set SCHED_FIFO priority " << settings.priority << ": " << strerror(error));
+            ok = false;
+        }
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int coreCount = 0;
+    if (0 == pthread_getaffinity_np(thread, sizeof(cpus), &cpus)) {
+        coreCount = CPU_COUNT(&cpus);
+    }
+    int policy;
+    sched_param parameters;
+    if (0 != pthread_getschedparam(thread, &policy, &parameters)) {
+        policy = SCHED_OTHER;
+        parameters.sched_priority = 0;
+    }
+    const char * policyName = (SCHED_FIFO == policy) ? "SCHED_FIFO" : (SCHED_RR == policy) ? "SCHED_RR" : "SCHED_OTHER";
+    if ((1 == coreCount) && (kVelodyneAnyCore != settings.core) && CPU_ISSET(settings.core, &cpus)) {
+        LOG_INFO(threadName << " thread: pinned on core " << settings.core
+                 << ", policy " << policyName << ", priority " << parameters.sched_priority);
+    } else {
+        LOG_INFO(threadName << " thread: may run on " << coreCount << " cores"
+                 << ", policy " << policyName << ", priority " << parameters.sched_priority);
+    }
+    return ok;
+#else
+    if ((kVelodyneAnyCore != settings.core) || (settings.priority > 0)) {
+        LOG_WARN(threadName << " thread: core and priority are only applied on Linux");
+        return false;
+    }
+    return true;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// SO_RCVBUFFORCE goes beyond net.core.rmem_max when the process has
+/// CAP_NET_ADMIN, SO_RCVBUF is used otherwise and is capped by the kernel
+bool pacpus::tuneSocket(int socket, const VelodyneSocketSettings & settings)
+{
+#ifdef __linux__
+    bool ok = true;
+
+    if (settings.receiveBufferSize > 0) {
+        int size = settings.receiveBufferSize;
+        if ((::setsockopt(socket, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0)
+                && (::setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0)) {
+            LOG_ERROR("cannot set the socket receive buffer to " << size << " bytes: " << strerror(errno));
+            ok = false;
+        }
+    }
+
+    if (settings.busyPollUs > 0) {
+#ifdef SO_BUSY_POLL
+        int busyPoll = settings.busyPollUs;
+        if (::setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll)) < 0) {
+            LOG_ERROR("cannot set socket busy polling to " << busyPoll << " us: " << strerror(errno));
+            ok = false;
+        }
+#else
+        LOG_WARN("socket busy polling is not supported by this system");
+        ok = false;
+#endif
+    }
+
+    int size = 0;
+    socklen_t length = sizeof(size);
+    ::getsockopt(socket, SOL_SOCKET, SO_RCVBUF, &size, &length);
+    int busyPoll = 0;
+#ifdef SO_BUSY_POLL
+    length = sizeof(busyPoll);
+    ::getsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, &length);
+#endif
+    // the kernel doubles the requested size for its bookkeeping
+    LOG_INFO("socket receive buffer " << size << " bytes, busy polling " << busyPoll << " us");
+    if ((settings.receiveBufferSize > 0) && (size < settings.receiveBufferSize)) {
+        LOG_WARN("socket receive buffer smaller than requested, raise net.core.rmem_max");
+    }
+    return ok;
+#else
+    Q_UNUSED(socket);
+    if ((settings.receiveBufferSize > 0) || (settings.busyPollUs > 0)) {
+        LOG_WARN("socket receive buffer and busy polling are only applied on Linux");
+        return false;
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,54 @@
+/// @file
+/// Scheduling of the Velodyne acquisition threads and tuning of their sockets
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNETHREADTUNING_H
+#define VELODYNETHREADTUNING_H
+
+namespace pacpus {
+
+/// No core given, the thread runs where the scheduler puts it
+static const int kVelodyneAnyCore = -1;
+
+/// Placement and priority of a thread, read from the component XML
+struct VelodyneThreadSettings
+{
+    VelodyneThreadSettings()
+        : core(kVelodyneAnyCore)
+        , priority(0)
+    {}
+
+    /// core on which the thread is pinned, kVelodyneAnyCore if none
+    int core;
+    /// SCHED_FIFO priority from 1 to 99, 0 keeps the default scheduling
+    int priority;
+};
+
+/// Options of a receiving UDP socket, 0 keeps the system default
+struct VelodyneSocketSettings
+{
+    VelodyneSocketSettings()
+        : receiveBufferSize(0)
+        , busyPollUs(0)
+    {}
+
+    /// SO_RCVBUF in bytes
+    int receiveBufferSize;
+    /// SO_BUSY_POLL in microseconds
+    int busyPollUs;
+};
+
+/// Applies the settings to the calling thread and logs the values obtained.
+/// Returns false if one of them could not be applied. Only available on Linux.
+bool tuneCurrentThread(const char * threadName, const VelodyneThreadSettings & settings);
+
+/// Applies the settings to a socket and logs the values obtained, which the
+/// kernel may have changed. Returns false if one of them could not be applied.
+bool tuneSocket(int socket, const VelodyneSocketSettings & settings);
+
+} // namespace pacpus
+
+#endif // VELODYNETHREADTUNING_H
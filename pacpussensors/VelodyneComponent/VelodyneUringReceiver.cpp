@@ -0,0 +1,268 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneUringReceiver.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Reception of the Velodyne UDP stream with io_uring
+//              multishot recvmsg into provided buffers
+//
+*********************************************************************/
+
+#include "VelodyneUringReceiver.h"
+
+#include "kernel/Log.h"
+
+#if defined(__linux__) && defined(VELODYNE_HAVE_LIBURING)
+#   include <algorithm>
+#   include <cerrno>
+#   include <cstring>
+#   include <liburing.h>
+#   include <sys/socket.h>
+#endif
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.base.VelodyneUringReceiver");
+
+/// Buffer group of the pool in the ring
+static const int kBufferGroup = 0;
+
+/// Period at which the reception loop checks if it has to stop
+static const long kCompletionTimeoutNs = 100 * 1000 * 1000;
+
+#if defined(__linux__) && defined(VELODYNE_HAVE_LIBURING)
+/// Ancillary data of a datagram, large enough for its SCM_TIMESTAMPNS
+static const size_t kControlSize = CMSG_SPACE(sizeof(timespec));
+
+/// Size of a buffer of the pool, the kernel writes the header of the
+/// message and its ancillary data before the datagram
+static const size_t kBufferSize = sizeof(io_uring_recvmsg_out) + kControlSize + sizeof(((VelodyneDatagram *) 0)->data);
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor, the pool is allocated once here
+VelodyneUringReceiver::VelodyneUringReceiver(VelodynePacketSink * sink)
+    : VelodyneReceiver(sink)
+    , mRing(NULL)
+    , mBufferRing(NULL)
+    , mMessage(NULL)
+    , mBuffers(NULL)
+    , mPool(NULL)
+{
+    mPool = new VelodyneDatagram[kPoolSize];
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneUringReceiver::~VelodyneUringReceiver()
+{
+    close();
+    delete[] mPool;
+}
+
+#if defined(__linux__) && defined(VELODYNE_HAVE_LIBURING)
+
+//////////////////////////////////////////////////////////////////////////
+/// Time at which the kernel received the datagram, in the time base of
+/// road_time(); defaultTime if not given
+static road_time_t receptionTime(io_uring_recvmsg_out * out, msghdr * message, road_time_t defaultTime)
+{
+    for (cmsghdr * control = io_uring_recvmsg_cmsg_firsthdr(out, message); NULL != control;
+         control = io_uring_recvmsg_cmsg_nexthdr(out, message, control)) {
+        if ((SOL_SOCKET == control->cmsg_level) && (SCM_TIMESTAMPNS == control->cmsg_type)) {
+            timespec time;
+            memcpy(&time, CMSG_DATA(control), sizeof(time));
+            return (road_time_t) time.tv_sec * 1000000 + time.tv_nsec / 1000;
+        }
+    }
+    return defaultTime;
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneUringReceiver::open(const QHostAddress & host, quint16 port, const QHostAddress & multicastGroup)
+{
+    if (!VelodyneReceiver::open(host, port, multicastGroup)) {
+        return false;
+    }
+
+    mRing = new io_uring;
+    // the ring only carries the receive request and its completions
+    int error = io_uring_queue_init(kPoolSize, mRing, 0);
+    if (error < 0) {
+        LOG_ERROR("cannot create io_uring: " << strerror(-error));
+        delete mRing;
+        mRing = NULL;
+        close();
+        return false;
+    }
+
+    mBufferRing = io_uring_setup_buf_ring(mRing, kPoolSize, kBufferGroup, 0, &error);
+    if (!mBufferRing) {
+        LOG_ERROR("cannot register the buffer ring: " << strerror(-error));
+        close();
+        return false;
+    }
+    mBuffers = new char[kPoolSize * kBufferSize];
+    int mask = io_uring_buf_ring_mask(kPoolSize);
+    for (int i = 0; i < kPoolSize; ++i) {
+        io_uring_buf_ring_add(mBufferRing, mBuffers + i * kBufferSize, kBufferSize, i, mask, i);
+    }
+    io_uring_buf_ring_advance(mBufferRing, kPoolSize);
+
+    // the kernel only uses the lengths to lay out the buffers
+    mMessage = new msghdr;
+    memset(mMessage, 0, sizeof(*mMessage));
+    mMessage->msg_controllen = kControlSize;
+
+    if (!armReceive()) {
+        close();
+        return false;
+    }
+    LOG_INFO("receiving Velodyne datagrams with io_uring in a pool of " << kPoolSize << " buffers");
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneUringReceiver::close()
+{
+    if (mRing) {
+        if (mBufferRing) {
+            io_uring_free_buf_ring(mRing, mBufferRing, kPoolSize, kBufferGroup);
+            mBufferRing = NULL;
+        }
+        io_uring_queue_exit(mRing);
+        delete mRing;
+        mRing = NULL;
+    }
+    delete mMessage;
+    mMessage = NULL;
+    delete[] mBuffers;
+    mBuffers = NULL;
+    VelodyneReceiver::close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneUringReceiver::armReceive()
+{
+    io_uring_sqe * sqe = io_uring_get_sqe(mRing);
+    if (!sqe) {
+        LOG_ERROR("io_uring submission queue full");
+        return false;
+    }
+    // the kernel picks a buffer of the group for each datagram
+    io_uring_prep_recvmsg_multishot(sqe, mSocket, mMessage, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    int error = io_uring_submit(mRing);
+    if (error < 0) {
+        LOG_ERROR("cannot submit the io_uring receive: " << strerror(-error));
+        return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The datagrams of a batch of completions are copied out of their buffers,
+/// which are given back to the kernel at once, and reach the sink in a
+/// single call
+void VelodyneUringReceiver::run()
+{
+    tuneCurrentThread("io_uring reception", mThreadSettings);
+
+    while (mRunning) {
+        __kernel_timespec timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = kCompletionTimeoutNs;
+        io_uring_cqe * cqe;
+        int error = io_uring_wait_cqe_timeout(mRing, &cqe, &timeout);
+        if (error < 0) {
+            if ((-ETIME != error) && (-EINTR != error)) {
+                LOG_ERROR("cannot wait for io_uring completions: " << strerror(-error));
+                QThread::msleep(kCompletionTimeoutNs / 1000000);
+            }
+            continue;
+        }
+
+        // get a timestamp, for the datagrams without reception time
+        road_time_t t = road_time();
+        bool rearm = false;
+        int count = 0;
+        int recycled = 0;
+        int mask = io_uring_buf_ring_mask(kPoolSize);
+        unsigned head;
+        unsigned seen = 0;
+        io_uring_for_each_cqe(mRing, head, cqe) {
+            ++seen;
+            if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                // the multishot receive ended, ENOBUFS when the pool was exhausted
+                rearm = true;
+            }
+            if (cqe->res < 0) {
+                if (-ENOBUFS != cqe->res) {
+                    LOG_ERROR("io_uring receive failed: " << strerror(-cqe->res));
+                }
+                continue;
+            }
+            if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+                continue;
+            }
+            int buffer = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            char * data = mBuffers + buffer * kBufferSize;
+            io_uring_recvmsg_out * out = io_uring_recvmsg_validate(data, cqe->res, mMessage);
+            // at most kPoolSize buffers are in use until they are given back below
+            if (out) {
+                VelodyneDatagram & datagram = mPool[count++];
+                datagram.time = receptionTime(out, mMessage, t);
+                // the length of the whole datagram, greater than the data if it was truncated
+                datagram.size = out->payloadlen;
+                size_t length = io_uring_recvmsg_payload_length(out, cqe->res, mMessage);
+                memcpy(datagram.data, io_uring_recvmsg_payload(out, mMessage), std::min(length, sizeof(datagram.data)));
+            } else {
+                LOG_ERROR("invalid io_uring message of " << cqe->res << " bytes");
+            }
+            // the datagram was copied, the buffer can be filled again
+            io_uring_buf_ring_add(mBufferRing, data, kBufferSize, buffer, mask, recycled++);
+        }
+        io_uring_buf_ring_advance(mBufferRing, recycled);
+        io_uring_cq_advance(mRing, seen);
+        if (count > 0) {
+            mSink->processDatagrams(mPool, count);
+        }
+
+        if (rearm && mRunning && !armReceive()) {
+            QThread::msleep(kCompletionTimeoutNs / 1000000);
+        }
+    }
+    LOG_INFO("ended io_uring reception thread");
+}
+
+#else
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneUringReceiver::open(const QHostAddress & /* host */, quint16 /* port */, const QHostAddress & /* multicastGroup */)
+{
+    LOG_ERROR("io_uring reception is not available, the component was built without liburing");
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneUringReceiver::close()
+{
+    VelodyneReceiver::close();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneUringReceiver::run()
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneUringReceiver::armReceive()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,63 @@
+/// @file
+/// Reception of the Velodyne UDP stream with io_uring
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNEURINGRECEIVER_H
+#define VELODYNEURINGRECEIVER_H
+
+#include "VelodyneReceiver.h"
+
+struct io_uring;
+struct io_uring_buf_ring;
+struct msghdr;
+
+namespace pacpus {
+
+/// VelodyneReceiver reading the socket with a single multishot recvmsg
+/// request of io_uring: the kernel keeps filling the buffers of a fixed
+/// pool, provided to it once through a buffer ring, and the thread only
+/// reaps the completions. No system call is made per datagram.
+///
+/// Each buffer receives the datagram with its SCM_TIMESTAMPNS, so that the
+/// datagrams are stamped one by one as with VelodyneReceiver.
+///
+/// Needs liburing 2.4 and Linux 6.0, the build defines
+/// VELODYNE_HAVE_LIBURING when liburing is found. Without it, open() fails.
+class VelodyneUringReceiver
+        : public VelodyneReceiver
+{
+public:
+    /// number of buffers of the pool, a power of 2 as required by the buffer ring
+    static const int kPoolSize = 256;
+
+    VelodyneUringReceiver(VelodynePacketSink * sink);
+    ~VelodyneUringReceiver();
+
+    /// Opens the socket, then sets up the ring and provides the pool to the kernel
+    bool open(const QHostAddress & host, quint16 port, const QHostAddress & multicastGroup = QHostAddress());
+    void close();
+
+protected:
+    void run();
+
+private:
+    /// Queues the multishot receive, again each time the kernel ends it
+    bool armReceive();
+
+    struct io_uring * mRing;
+    struct io_uring_buf_ring * mBufferRing;
+    /// layout of the buffers: no address, room for the ancillary data
+    struct msghdr * mMessage;
+    /// buffers provided to the kernel, each one holding an
+    /// io_uring_recvmsg_out header, the ancillary data and the datagram
+    char * mBuffers;
+    /// datagrams of a batch of completions, passed to the sink at once
+    VelodyneDatagram * mPool;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNEURINGRECEIVER_H
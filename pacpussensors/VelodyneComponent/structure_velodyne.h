@@ -3,16 +3,28 @@
 
 // VELODYNE_BLOCK_SIZE = sizeof(unsigned short = uint16) * 2 + sizeof(VelodyneRawPoint = uint16,uint8) * kVelodynePointsPerBlock = 2*2 + (2+1)*32 = 4 + 96 = 100
 #define VELODYNE_BLOCK_SIZE 100
-// FIXME: unused
-// VELODYNE_PACKET_SIZE =
+// VELODYNE_PACKET_SIZE = VELODYNE_BLOCK_SIZE * VELODYNE_NB_BLOCKS_PER_PACKET + VELODYNE_STATUS_SIZE = 100*12 + 6 = 1206
 #define VELODYNE_PACKET_SIZE 1206
 #define VELODYNE_SCAN_SIZE 4166
 #define VELODYNE_NB_BLOCKS_PER_PACKET 12
+// VELODYNE_MAX_PACKETS_PER_SCAN = VELODYNE_SCAN_SIZE / VELODYNE_NB_BLOCKS_PER_PACKET rounded up + 1 packet shared with the next revolution = 348 + 1 = 349
+#define VELODYNE_MAX_PACKETS_PER_SCAN 349
+// VELODYNE_STATUS_SIZE = trailing bytes of a packet after the 12 blocks
+#define VELODYNE_STATUS_SIZE 6
 
 #define kVelodyneUpperBlock 0xEEFF
 #define kVelodyneLowerBlock 0xDDFF
 #define kVelodynePointsPerBlock 32
 
+// first 2 bytes of a compact revolution record, cannot be mistaken for kVelodyneUpperBlock or kVelodyneLowerBlock
+#define kVelodyneCompactScanMagic 0x5643
+// first 2 bytes of a raw packet record
+#define kVelodynePacketRecordMagic 0x5650
+// first 2 bytes of an azimuth sector record
+#define kVelodyneSectorMagic 0x5653
+// VelodyneSectorHeader::flags of the sector which ends a revolution
+#define kVelodyneLastSector 0x0001
+
 #pragma pack(push, 1)
 
 // 3 bytes size
@@ -43,20 +55,46 @@ typedef struct VelodyneBlock
 	*/
 } VelodyneBlock;
 
-// size : VELODYNE_BLOCK_SIZE*VELODYNE_SCAN_SIZE + sizeof(unsigned short = uint16)*VELODYNE_SCAN_SIZE
+// 1206=VELODYNE_PACKET_SIZE bytes size
+// view of a UDP datagram as sent by the sensor, multi-byte fields are little-endian on the wire
+typedef struct VelodynePacket
+{
+    /// 12 blocks of 32 beams
+    VelodyneBlock blocks[VELODYNE_NB_BLOCKS_PER_PACKET];
+
+    /// status bytes: 4 bytes of GPS timestamp, then status type and value (see p. 29 Rev C 2011)
+    uint8_t status[VELODYNE_STATUS_SIZE];
+} VelodynePacket;
+
+// size : 2 + 4 + 4 = 10 bytes
+// timing of a packet whose blocks are in a VelodynePolarData
+typedef struct VelodynePacketTiming
+{
+    /// index in polarData of the first block of the packet, its following blocks come from the same packet
+    /// until the firstBlock of the next timing
+    uint16_t firstBlock;
+    /// arrival time of the packet in microseconds after VelodynePolarData::time
+    uint32_t arrivalOffset;
+    /// GPS timestamp of the status bytes, in microseconds since the top of the hour
+    uint32_t gpsTimestamp;
+} VelodynePacketTiming;
+
+// size : VELODYNE_BLOCK_SIZE*VELODYNE_SCAN_SIZE + sizeof(VelodynePacketTiming)*VELODYNE_MAX_PACKETS_PER_SCAN + sizeof(int16) + reserved
 //          + sizeof(road_time_t = unsigned long long = uint64) + sizeof(road_timerange_t = int = int32) + sizeof(short = int16)
-//      = 100*4166 + 2*4166 + 8 + 4 + 2 = 424 946 bytes
+//      = 100*4166 + (10*349 + 2 + 4840 = 2*4166) + 8 + 4 + 2 = 424 946 bytes
 // structure containing data of a complete revolution of the lidar
 typedef struct VelodynePolarData
 {
     /// data of one block of 32 beams (upper or lower)
     VelodyneBlock polarData[VELODYNE_SCAN_SIZE];
 
-    /// scan count relative to polarData above
-    uint16_t scanCount[VELODYNE_SCAN_SIZE];
-
-    /// Timestamp of each block.
-    //road_time_t dataTime[VELODYNE_SCAN_SIZE];
+    /// timing of the packets the blocks come from, in the order of polarData
+    VelodynePacketTiming packetTiming[VELODYNE_MAX_PACKETS_PER_SCAN];
+    /// number of valid packetTiming, 0 if unknown
+    int16_t packetCount;
+    /// keeps the size of the former uint16_t scanCount[VELODYNE_SCAN_SIZE], which was never filled,
+    /// so that the records do not change of size
+    uint8_t reserved[2 * VELODYNE_SCAN_SIZE - VELODYNE_MAX_PACKETS_PER_SCAN * 10 - 2];
 
     /// time got in the packet containing first angle
     road_time_t time;
@@ -68,6 +106,77 @@ typedef struct VelodynePolarData
     int16_t range;
 } VelodynePolarData;
 
+// size : 2 + 2 + 8 + 4 + 2 = 18 bytes
+// header of a compact revolution record, followed by the packetCount entries of VelodynePolarData::packetTiming,
+// then by the range valid blocks of VelodynePolarData::polarData
+// record size = sizeof(VelodyneCompactScanHeader) + packetCount * sizeof(VelodynePacketTiming) + range * VELODYNE_BLOCK_SIZE
+typedef struct VelodyneCompactScanHeader
+{
+    /// kVelodyneCompactScanMagic, a VelodynePolarData starts with a block identifier instead
+    uint16_t magic;
+    /// number of blocks following the header
+    int16_t range;
+    /// time got in the packet containing first angle
+    road_time_t time;
+    /// timerange = diff( t(angle=0) - t(lastangle) )
+    road_timerange_t timerange;
+    /// number of VelodynePacketTiming following the header, 0 if unknown
+    int16_t packetCount;
+} VelodyneCompactScanHeader;
+
+// size : 2 + 2 = 4 bytes
+// header of a raw packet record, followed by the size bytes of the datagram as received
+typedef struct VelodynePacketRecordHeader
+{
+    /// kVelodynePacketRecordMagic
+    uint16_t magic;
+    /// number of bytes following the header, VELODYNE_PACKET_SIZE for a valid packet
+    uint16_t size;
+} VelodynePacketRecordHeader;
+
+// size : 8 + 8 = 16 bytes
+// entry of the time index written beside a file of raw packet records
+typedef struct VelodynePacketIndexEntry
+{
+    /// arrival time of the packet
+    road_time_t time;
+    /// number of the record of this packet in the dbt file, starting at 0
+    uint64_t record;
+} VelodynePacketIndexEntry;
+
+// size : 2 + 2 + 2 + 2 + 4 + 2 + 2 + 8 + 4 + 2 = 30 bytes
+// header of an azimuth sector published before its revolution is complete, followed by the packetCount
+// timings of the packets its blocks come from, then by the blockCount blocks of VelodynePolarData::polarData
+// starting at firstBlock
+// record size = sizeof(VelodyneSectorHeader) + packetCount * sizeof(VelodynePacketTiming) + blockCount * VELODYNE_BLOCK_SIZE
+typedef struct VelodyneSectorHeader
+{
+    /// kVelodyneSectorMagic
+    uint16_t magic;
+    /// azimuth of the blocks divided by sectorWidth, the last sector of a revolution may hold blocks of the next id
+    uint16_t sectorId;
+    /// width of the sectors in hundredths of degree
+    uint16_t sectorWidth;
+    /// kVelodyneLastSector when the revolution is complete after this sector
+    uint16_t flags;
+    /// number of the revolution, incremented by one at each revolution since the acquisition started
+    uint32_t revolutionId;
+    /// index in the revolution of the first block of the sector
+    int16_t firstBlock;
+    /// number of blocks following the header, may be 0 for the last sector
+    int16_t blockCount;
+    /// time got in the packet containing the first angle of the revolution
+    road_time_t time;
+    /// time elapsed since the start of the revolution when the sector was complete
+    road_timerange_t timerange;
+    /// number of VelodynePacketTiming following the header, the first one may be the packet of the previous sector's last blocks
+    int16_t packetCount;
+} VelodyneSectorHeader;
+
 #pragma pack(pop)
 
+// size of the largest sector record, a whole revolution in a single sector
+#define VELODYNE_SECTOR_MAX_RECORD_SIZE (sizeof(VelodyneSectorHeader) + VELODYNE_MAX_PACKETS_PER_SCAN * sizeof(VelodynePacketTiming) \
+                                         + VELODYNE_SCAN_SIZE * VELODYNE_BLOCK_SIZE)
+
 #endif // STRUCTURE_VELODYNE_H
@@ -0,0 +1,325 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodynePacketGenerator.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Sends synthetic HDL-64S2 packets over UDP to load the
+//              VelodyneComponent without a sensor
+//
+*********************************************************************/
+
+#include "kernel/cstdint.h"
+#include "kernel/road_time.h"
+#include "../VelodyneComponent/structure_velodyne.h"
+
+#include <QHostAddress>
+#include <QString>
+#include <QtEndian>
+#include <QUdpSocket>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef WIN32
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
+
+/// Generation parameters, given on the command line
+struct GeneratorOptions
+{
+    QString host;
+    quint16 port;
+    /// rotation frequency in Hz, the HDL-64S2 spins from 5 to 20 Hz
+    double frequency;
+    /// packets sent per second
+    int packetRate;
+    /// probability for a packet not to be sent
+    double lossRate;
+    /// probability for a packet to be sent after the next one
+    double reorderRate;
+    /// seconds of generation, 0 to run until interrupted
+    double duration;
+    unsigned seed;
+};
+
+/// Builds valid HDL-64S2 packets: upper and lower blocks fired at the same
+/// azimuth, an azimuth sweep at the rotation frequency, and status bytes
+/// cycling through the GPS time, the temperature and the firmware version.
+class VelodynePacketGenerator
+{
+public:
+    VelodynePacketGenerator(double frequency, int packetRate)
+        : mAzimuth(0)
+        , mStatusIndex(0)
+        , mRevolutionCount(0)
+    {
+        // 6 firings of an upper and a lower block per packet
+        mAzimuthStep = 36000.0 * frequency / (packetRate * VELODYNE_NB_BLOCKS_PER_PACKET / 2);
+    }
+
+    /// Fills the next packet of the sweep, time is the sensor time of the packet
+    void fill(VelodynePacket * packet, road_time_t time)
+    {
+        for (int i = 0; i < VELODYNE_NB_BLOCKS_PER_PACKET; i += 2) {
+            quint16 angle = (quint16) mAzimuth;
+            fillBlock(&packet->blocks[i], kVelodyneUpperBlock, angle);
+            fillBlock(&packet->blocks[i + 1], kVelodyneLowerBlock, angle);
+            mAzimuth += mAzimuthStep;
+            if (mAzimuth >= 36000) {
+                mAzimuth -= 36000;
+                ++mRevolutionCount;
+            }
+        }
+        fillStatus(packet->status, time);
+    }
+
+    quint64 revolutionCount() const
+    {
+        return mRevolutionCount;
+    }
+
+private:
+    void fillBlock(VelodyneBlock * block, quint16 identifier, quint16 angle)
+    {
+        qToLittleEndian<quint16>(identifier, reinterpret_cast<uchar *>(&block->block));
+        qToLittleEndian<quint16>(angle, reinterpret_cast<uchar *>(&block->angle));
+        // a wall 20 m away, closer in front of the sensor, distances by 0.2 cm
+        double range = 20.0 - 10.0 * exp(-pow((angle - 18000) / 2000.0, 2));
+        for (int j = 0; j < kVelodynePointsPerBlock; ++j) {
+            quint16 distance = (quint16) ((range + 0.05 * j) / 0.002);
+            qToLittleEndian<quint16>(distance, reinterpret_cast<uchar *>(&block->rawPoints[j].distance));
+            block->rawPoints[j].intensity = (uint8_t) ((angle / 100 + 8 * j) & 0xff);
+        }
+    }
+
+    /// GPS time in microseconds since the top of the hour, then a status
+    /// type and its value
+    void fillStatus(uint8_t * status, road_time_t time)
+    {
+        static const char kStatusTypes[] = { 'H', 'M', 'S', 'D', 'N', 'Y', 'T', 'V' };
+        qToLittleEndian<quint32>((quint32) (time % ((road_time_t) 3600 * 1000000)), status);
+        char type = kStatusTypes[mStatusIndex];
+        uint8_t value;
+        switch (type) {
+        case 'H': value = (uint8_t) (time / 3600000000ULL % 24); break;
+        case 'M': value = (uint8_t) (time / 60000000ULL % 60); break;
+        case 'S': value = (uint8_t) (time / 1000000ULL % 60); break;
+        case 'T': value = 42; break;
+        case 'V': value = 0x10; break;
+        default: value = 1; break;
+        }
+        status[4] = type;
+        status[5] = value;
+        mStatusIndex = (mStatusIndex + 1) % sizeof(kStatusTypes);
+    }
+
+    double mAzimuth;
+    double mAzimuthStep;
+    int mStatusIndex;
+    quint64 mRevolutionCount;
+};
+
+/// Counters printed every second
+struct GeneratorStatistics
+{
+    quint64 generatedCount;
+    quint64 sentCount;
+    quint64 lostCount;
+    quint64 reorderedCount;
+    quint64 errorCount;
+};
+
+//////////////////////////////////////////////////////////////////////////
+static void report(const GeneratorStatistics & statistics, const VelodynePacketGenerator & generator)
+{
+    printf("generated %llu, sent %llu, lost %llu, reordered %llu, send errors %llu, revolutions %llu\n",
+           (unsigned long long) statistics.generatedCount, (unsigned long long) statistics.sentCount,
+           (unsigned long long) statistics.lostCount, (unsigned long long) statistics.reorderedCount,
+           (unsigned long long) statistics.errorCount, (unsigned long long) generator.revolutionCount());
+    fflush(stdout);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Sends a whole packet, counts it as sent or as an error
+static void send(QUdpSocket & socket, const VelodynePacket & packet, const GeneratorOptions & options,
+                 const QHostAddress & host, GeneratorStatistics * statistics)
+{
+    if (VELODYNE_PACKET_SIZE == socket.writeDatagram((const char *) &packet, VELODYNE_PACKET_SIZE, host, options.port)) {
+        ++statistics->sentCount;
+    } else {
+        ++statistics->errorCount;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void usage(const char * program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --host ADDRESS      destination address (default 127.0.0.1)\n"
+            "  --port PORT         destination port (default 2368)\n"
+            "  --frequency HZ      rotation frequency, 5 to 20 Hz (default 10)\n"
+            "  --rate PACKETS      packets per second (default 2600)\n"
+            "  --loss P            probability to drop a packet (default 0)\n"
+            "  --reorder P         probability to swap a packet with the next one (default 0)\n"
+            "  --duration SECONDS  stop after this time, 0 to run until interrupted (default 0)\n"
+            "  --seed N            seed of the loss and reorder pattern (default 1)\n",
+            program);
+}
+
+//////////////////////////////////////////////////////////////////////////
+static bool parseOptions(int argc, char ** argv, GeneratorOptions * options)
+{
+    options->host = "127.0.0.1";
+    options->port = 2368;
+    options->frequency = 10;
+    options->packetRate = 2600;
+    options->lossRate = 0;
+    options->reorderRate = 0;
+    options->duration = 0;
+    options->seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char * name = argv[i];
+        const char * value = argv[++i];
+        if (!strcmp(name, "--host")) {
+            options->host = value;
+        } else if (!strcmp(name, "--port")) {
+            options->port = (quint16) atoi(value);
+        } else if (!strcmp(name, "--frequency")) {
+            options->frequency = atof(value);
+        } else if (!strcmp(name, "--rate")) {
+            options->packetRate = atoi(value);
+        } else if (!strcmp(name, "--loss")) {
+            options->lossRate = atof(value);
+        } else if (!strcmp(name, "--reorder")) {
+            options->reorderRate = atof(value);
+        } else if (!strcmp(name, "--duration")) {
+            options->duration = atof(value);
+        } else if (!strcmp(name, "--seed")) {
+            options->seed = (unsigned) atoi(value);
+        } else {
+            return false;
+        }
+    }
+    if ((options->frequency < 5) || (options->frequency > 20)) {
+        fprintf(stderr, "the rotation frequency must be between 5 and 20 Hz\n");
+        return false;
+    }
+    if (options->packetRate <= 0) {
+        fprintf(stderr, "the packet rate must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void sleepUs(unsigned long us)
+{
+#ifdef WIN32
+    Sleep(us / 1000);
+#else
+    usleep(us);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Set on SIGINT or SIGTERM, the run then ends like when its duration is reached
+static volatile sig_atomic_t sStopRequested = 0;
+
+static void requestStop(int)
+{
+    sStopRequested = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static bool draw(double probability)
+{
+    return (probability > 0) && (rand() < probability * RAND_MAX);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    GeneratorOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    srand(options.seed);
+
+    QHostAddress host;
+    if (!host.setAddress(options.host)) {
+        fprintf(stderr, "invalid address '%s'\n", options.host.toLocal8Bit().constData());
+        return 1;
+    }
+    QUdpSocket socket;
+
+    printf("sending HDL-64S2 packets to %s:%d at %d packets/s, %.1f Hz, loss %.3f, reorder %.3f\n",
+           options.host.toLocal8Bit().constData(), options.port, options.packetRate,
+           options.frequency, options.lossRate, options.reorderRate);
+
+    VelodynePacketGenerator generator(options.frequency, options.packetRate);
+    VelodynePacket packet;
+    VelodynePacket heldPacket;
+    bool held = false;
+
+    GeneratorStatistics statistics;
+    memset(&statistics, 0, sizeof(statistics));
+
+    road_time_t start = road_time();
+    road_time_t lastReport = start;
+    road_time_t end = start + (road_time_t) (options.duration * 1000000);
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    while (!sStopRequested) {
+        road_time_t now = road_time();
+        if ((options.duration > 0) && (now >= end)) {
+            break;
+        }
+
+        // packets whose time has come since the last loop
+        quint64 dueCount = (now - start) * options.packetRate / 1000000;
+        for (; statistics.generatedCount < dueCount; ++statistics.generatedCount) {
+            generator.fill(&packet, start + statistics.generatedCount * 1000000 / options.packetRate);
+            if (draw(options.lossRate)) {
+                ++statistics.lostCount;
+                continue;
+            }
+            if (!held && draw(options.reorderRate)) {
+                // sent after the next packet
+                heldPacket = packet;
+                held = true;
+                continue;
+            }
+            send(socket, packet, options, host, &statistics);
+            if (held) {
+                send(socket, heldPacket, options, host, &statistics);
+                held = false;
+                ++statistics.reorderedCount;
+            }
+        }
+
+        if (now - lastReport >= 1000000) {
+            report(statistics, generator);
+            lastReport = now;
+        }
+        sleepUs(200);
+    }
+    // no packet follows the one held back, it is sent in order
+    if (held) {
+        send(socket, heldPacket, options, host, &statistics);
+    }
+    report(statistics, generator);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneStatsMonitor.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Prints the acquisition statistics published by a running
+//              VelodyneComponent
+//
+*********************************************************************/
+
+#include "kernel/road_time.h"
+#include "PacpusTools/ShMem.h"
+#include "../VelodyneComponent/VelodyneStatistics.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef WIN32
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
+
+using namespace pacpus;
+
+/// Monitoring parameters, given on the command line
+struct MonitorOptions
+{
+    /// shared memory of the component, as its shmem property
+    std::string sharedMemoryName;
+    /// milliseconds between two lines
+    int intervalMs;
+    /// number of lines printed, 0 to run until interrupted
+    int count;
+};
+
+//////////////////////////////////////////////////////////////////////////
+static void usage(const char * program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --shmem NAME        shared memory of the component (default VELODYNE)\n"
+            "  --interval MS       time between two lines (default 1000)\n"
+            "  --count N           stop after N lines, 0 to run until interrupted (default 0)\n",
+            program);
+}
+
+//////////////////////////////////////////////////////////////////////////
+static bool parseOptions(int argc, char ** argv, MonitorOptions * options)
+{
+    options->sharedMemoryName = "VELODYNE";
+    options->intervalMs = 1000;
+    options->count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char * name = argv[i];
+        const char * value = argv[++i];
+        if (!strcmp(name, "--shmem")) {
+            options->sharedMemoryName = value;
+        } else if (!strcmp(name, "--interval")) {
+            options->intervalMs = atoi(value);
+        } else if (!strcmp(name, "--count")) {
+            options->count = atoi(value);
+        } else {
+            return false;
+        }
+    }
+    if (options->intervalMs <= 0) {
+        fprintf(stderr, "the interval must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void sleepMs(int ms)
+{
+#ifdef WIN32
+    Sleep(ms);
+#else
+    usleep(ms * 1000);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void printHeader()
+{
+    printf("%8s %9s %10s %8s %8s %8s %8s %8s %7s %7s %6s %6s %6s %8s %8s %8s\n",
+           "age(ms)", "packets/s", "MB/s", "ringdrop", "malform", "gaps", "reorder", "overflow",
+           "revs", "revdrop", "blocks", "min", "max", "period", "mean", "jitter");
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void printStatistics(const VelodyneStatistics & s)
+{
+    long long age = (long long) (road_time() - s.updateTime) / 1000;
+    printf("%8lld %9.0f %10.2f %8llu %8llu %8llu %8llu %8llu %7llu %7llu %6d %6d %6d %8d %8.0f %8.0f\n",
+           age, s.packetRate, s.byteRate / 1e6,
+           (unsigned long long) s.ringDropCount, (unsigned long long) s.malformedPacketCount,
+           (unsigned long long) s.azimuthGapCount, (unsigned long long) s.outOfOrderCount,
+           (unsigned long long) s.overflowBlockCount, (unsigned long long) s.revolutionCount,
+           (unsigned long long) s.droppedRevolutionCount,
+           s.lastRevolutionBlocks, s.minRevolutionBlocks, s.maxRevolutionBlocks,
+           s.lastPeriodUs, s.meanPeriodUs, s.periodJitterUs);
+    fflush(stdout);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    MonitorOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::string name = options.sharedMemoryName + VELODYNE_STATISTICS_SUFFIX;
+    ShMem shMem(name.c_str(), sizeof(VelodyneStatistics));
+    VelodyneStatistics * shared = static_cast<VelodyneStatistics *>(shMem.read());
+    if (!shared) {
+        fprintf(stderr, "cannot open shared memory '%s'\n", name.c_str());
+        return 1;
+    }
+
+    for (int line = 0; (0 == options.count) || (line < options.count); ++line) {
+        if (0 == line % 20) {
+            printHeader();
+        }
+        VelodyneStatistics statistics;
+        if (!readVelodyneStatistics(shared, &statistics)) {
+            printf("statistics being written, no consistent snapshot\n");
+        } else if (kVelodyneStatisticsMagic != statistics.magic) {
+            printf("no statistics published in '%s' yet\n", name.c_str());
+        } else {
+            printStatistics(statistics);
+        }
+        sleepMs(options.intervalMs);
+    }
+    return 0;
+}
@@ -132,6 +132,17 @@ void ComputingComponent::processCorrected(VelodyneCartData * incomingData)
     wi->updatePointCloud(locale_cloud->makeShared());
 }
 
+void ComputingComponent::processCloud(VelodyneCloud * incomingData)
+{
+    LOG_TRACE(BOOST_CURRENT_FUNCTION);
+    //local run variables
+    pcl::PointCloud<pcl::PointXYZ>::Ptr locale_cloud (new pcl::PointCloud<pcl::PointXYZ>);
+
+    SetPointCloudFromScan(incomingData,locale_cloud);
+
+    wi->updatePointCloud(locale_cloud->makeShared());
+}
+
 void ComputingComponent::SetPointCloudFromScan(VelodyneCartData * m_incomingData,pcl::PointCloud<pcl::PointXYZ>::Ptr locale_cloud)
 {
     LOG_TRACE(BOOST_CURRENT_FUNCTION);
@@ -157,6 +168,32 @@ void ComputingComponent::SetPointCloudFromScan(VelodyneCartData * m_incomingData
     }
 }
 
+/// Same organized cloud, one column per block, the points without return being at the origin
+void ComputingComponent::SetPointCloudFromScan(VelodyneCloud * m_incomingData,pcl::PointCloud<pcl::PointXYZ>::Ptr locale_cloud)
+{
+    LOG_TRACE(BOOST_CURRENT_FUNCTION);
+
+    int width=VELODYNE_SCAN_SIZE;
+    int height=32;
+    int pointCount=m_incomingData->range*height;
+
+    // Fill in the cloud data
+    locale_cloud->width    = width;
+    locale_cloud->height   = height;
+    locale_cloud->is_dense = false;
+    locale_cloud->points.resize (locale_cloud->width * locale_cloud->height);
+
+    const float * x = m_incomingData->x;
+    const float * y = m_incomingData->y;
+    const float * z = m_incomingData->z;
+    for (int i = 0; i < pointCount; ++i)
+    {
+        locale_cloud->points[i].x = x[i];
+        locale_cloud->points[i].y = y[i];
+        locale_cloud->points[i].z = z[i];
+    }
+}
+
 /*
 void ComputingComponent::SetPointCloudFromScan(ScanAlascaData * m_incomingData,pcl::PointCloud<pcl::PointXYZ>::Ptr locale_cloud)
 {
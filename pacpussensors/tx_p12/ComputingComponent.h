@@ -58,9 +58,15 @@ public:
 
     void processRaw(VelodynePolarData *);
     void processCorrected(VelodyneCartData *);
+    void processCloud(VelodyneCloud *);
+    /// only the corrected data is used
+    bool usesRawData() const { return false; }
+    /// the points are copied from the arrays of a VelodyneCloud
+    bool usesCloud() const { return true; }
 
 private:
     void SetPointCloudFromScan(VelodyneCartData *, pcl::PointCloud<pcl::PointXYZ>::Ptr);
+    void SetPointCloudFromScan(VelodyneCloud *, pcl::PointCloud<pcl::PointXYZ>::Ptr);
 //    void SetPointCloudFromScan(ScanAlascaData *, pcl::PointCloud<pcl::PointXYZ>::Ptr);
 
     QMutex m_mutex;
@@ -0,0 +1,54 @@
+/// @file
+/// Converted Velodyne revolution with one array per field
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNECLOUD_H
+#define VELODYNECLOUD_H
+
+#include "kernel/road_time.h"
+#include "../VelodyneComponent/structure_velodyne.h"
+
+namespace pacpus {
+
+/// Converted revolution, the alternative to VelodyneCartData for the loops
+/// running over all the points: the fields are in separate float arrays
+/// instead of packed structures holding doubles.
+///
+/// Point i is the point i % 32 of the block i / 32 of the revolution. The
+/// points of the blocks [0, range) are filled, those without return having
+/// null coordinates and not being valid. All the fields of the points of a block with an
+/// invalid signature are null, laser and azimuth included. Each array is a
+/// multiple of 64 bytes long, so all of them are aligned on a cache line
+/// when the cloud is, as in a VelodyneBuffer.
+struct VelodyneCloud
+{
+    static const int kMaxPointCount = VELODYNE_SCAN_SIZE * kVelodynePointsPerBlock;
+
+    /// in meter
+    float x[kMaxPointCount];
+    float y[kMaxPointCount];
+    float z[kMaxPointCount];
+    /// calibrated, 255 most intense return
+    float intensity[kMaxPointCount];
+    /// in meter
+    float distance[kMaxPointCount];
+    /// 1 for a return, 0 otherwise
+    uint8_t valid[kMaxPointCount];
+    /// laser which fired the point, from 0 to 63
+    uint8_t laser[kMaxPointCount];
+    /// azimuth of the block, in hundredths of degree
+    uint16_t azimuth[kMaxPointCount];
+
+    /// blocks the points come from, range * 32 points are filled
+    short range;
+    /// same time as the polar data of the revolution
+    road_time_t time;
+    road_timerange_t timerange;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNECLOUD_H
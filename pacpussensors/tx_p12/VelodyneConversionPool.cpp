@@ -0,0 +1,223 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneConversionPool.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Conversion of the Velodyne revolutions split across
+//              worker threads
+//
+*********************************************************************/
+
+#include "VelodyneConversionPool.h"
+
+#include "kernel/Log.h"
+
+#include <algorithm>
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.cityvip.VelodyneConversionPool");
+
+/// Smallest chunk, so that taking a chunk stays cheap compared with converting it
+static const int kMinChunkBlocks = 128;
+
+/// Chunks per thread, so that a thread woken late still finds some to convert
+static const int kChunksPerThread = 4;
+
+/// Maximal time to wait for a worker to stop
+static const unsigned long kMaxWaitForThreadTimeMs = 1000;
+
+//////////////////////////////////////////////////////////////////////////
+/// Thread of the pool, only runs VelodyneConversionPool::workerLoop()
+class VelodyneConversionPool::Worker
+        : public QThread
+{
+public:
+    explicit Worker(VelodyneConversionPool * pool)
+        : mPool(pool)
+    {}
+
+protected:
+    void run()
+    {
+        tuneCurrentThread("conversion worker", mPool->mWorkerSettings);
+        mPool->workerLoop();
+    }
+
+private:
+    VelodyneConversionPool * mPool;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor, without worker until start()
+VelodyneConversionPool::VelodyneConversionPool(const VelodyneConverter & converter)
+    : mConverter(converter)
+    , mGeneration(0)
+    , mBusyWorkers(0)
+    , mStopping(false)
+    , mBlocks(NULL)
+    , mCart(NULL)
+    , mCloud(NULL)
+    , mEndBlock(0)
+    , mChunkSize(kMinChunkBlocks)
+    , mNextBlock(0)
+    , mPointCount(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Destructor
+VelodyneConversionPool::~VelodyneConversionPool()
+{
+    stop();
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneConversionPool::start(int threadCount, const VelodyneThreadSettings & settings)
+{
+    stop();
+
+    mWorkerSettings = settings;
+    mWorkerSettings.core = kVelodyneAnyCore;
+    mStopping = false;
+    for (int i = 1; i < threadCount; ++i) {
+        Worker * worker = new Worker(this);
+        mWorkers.push_back(worker);
+        worker->start();
+    }
+    LOG_INFO("conversion split across " << threadCount << " threads");
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneConversionPool::stop()
+{
+    if (mWorkers.empty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mMutex);
+        mStopping = true;
+        mStarted.wakeAll();
+    }
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        if (!mWorkers[i]->wait(kMaxWaitForThreadTimeMs)) {
+            mWorkers[i]->terminate();
+            LOG_ERROR("conversion worker was blocking. It has been terminated");
+        }
+        delete mWorkers[i];
+    }
+    mWorkers.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneConversionPool::threadCount() const
+{
+    return (int) mWorkers.size() + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneConversionPool::convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCartData * cart)
+{
+    return convert(blocks, firstBlock, endBlock, cart, NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneConversionPool::convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCloud * cloud)
+{
+    return convert(blocks, firstBlock, endBlock, NULL, cloud);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The calling thread converts chunks as well, then waits for the workers
+/// still converting theirs. The workers woken too late to find a chunk
+/// only take the mutex and leave.
+int VelodyneConversionPool::convert(const VelodyneBlock * blocks, int firstBlock, int endBlock,
+                                    VelodyneCartData * cart, VelodyneCloud * cloud)
+{
+    const int blockCount = endBlock - firstBlock;
+    if (mWorkers.empty() || (blockCount <= kMinChunkBlocks)) {
+        return cart ? mConverter.convert(blocks, firstBlock, endBlock, cart)
+                    : mConverter.convert(blocks, firstBlock, endBlock, cloud);
+    }
+
+    {
+        QMutexLocker locker(&mMutex);
+        // a worker woken for the previous conversion may still be reading it
+        while (mBusyWorkers > 0) {
+            mFinished.wait(&mMutex);
+        }
+        int chunkSize = (blockCount + threadCount() * kChunksPerThread - 1) / (threadCount() * kChunksPerThread);
+        mChunkSize = std::max(kMinChunkBlocks, chunkSize);
+        mBlocks = blocks;
+        mCart = cart;
+        mCloud = cloud;
+        mEndBlock = endBlock;
+        mNextBlock.fetchAndStoreRelaxed(firstBlock);
+        mPointCount = 0;
+        ++mGeneration;
+        mStarted.wakeAll();
+    }
+
+    int pointCount = convertChunks();
+
+    QMutexLocker locker(&mMutex);
+    while (mBusyWorkers > 0) {
+        mFinished.wait(&mMutex);
+    }
+    return pointCount + mPointCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneConversionPool::workerLoop()
+{
+    int generation = 0;
+    forever {
+        {
+            QMutexLocker locker(&mMutex);
+            while (!mStopping && (generation == mGeneration)) {
+                mStarted.wait(&mMutex);
+            }
+            if (mStopping) {
+                return;
+            }
+            generation = mGeneration;
+            ++mBusyWorkers;
+        }
+
+        int pointCount = convertChunks();
+
+        QMutexLocker locker(&mMutex);
+        mPointCount += pointCount;
+        if (0 == --mBusyWorkers) {
+            mFinished.wakeAll();
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The chunks are taken in azimuth order by whichever thread is free
+int VelodyneConversionPool::convertChunks()
+{
+    int pointCount = 0;
+    forever {
+        int first = mNextBlock.fetchAndAddRelaxed(mChunkSize);
+        if (first >= mEndBlock) {
+            break;
+        }
+        pointCount += convertRange(first, std::min(first + mChunkSize, mEndBlock));
+    }
+    return pointCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneConversionPool::convertRange(int firstBlock, int endBlock) const
+{
+    if (mCart) {
+        return mConverter.convert(mBlocks, firstBlock, endBlock, mCart);
+    }
+    return mConverter.convert(mBlocks, firstBlock, endBlock, mCloud);
+}
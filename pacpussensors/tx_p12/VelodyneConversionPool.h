@@ -0,0 +1,90 @@
+/// @file
+/// Conversion of the Velodyne revolutions split across worker threads
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNECONVERSIONPOOL_H
+#define VELODYNECONVERSIONPOOL_H
+
+#include <qmutex.h>
+#include <qthread.h>
+#include <qwaitcondition.h>
+#include <QAtomicInt>
+#include <vector>
+
+#include "../VelodyneComponent/VelodyneThreadTuning.h"
+#include "VelodyneConverter.h"
+
+namespace pacpus {
+
+/// Converts the blocks of a revolution with a VelodyneConverter, split into
+/// chunks of consecutive blocks, that is azimuth sectors, shared by
+/// persistent worker threads and by the calling thread.
+///
+/// Every block is converted by the same kernel whatever the thread, so the
+/// result is identical to a conversion on the calling thread alone.
+class VelodyneConversionPool
+{
+public:
+    explicit VelodyneConversionPool(const VelodyneConverter & converter);
+    ~VelodyneConversionPool();
+
+    /// Starts threadCount - 1 workers, the calling thread of convert() being
+    /// the last one, with the priority of settings but on any core
+    void start(int threadCount, const VelodyneThreadSettings & settings);
+    /// Stops the workers, convert() then runs on the calling thread alone
+    void stop();
+    /// Workers plus the calling thread
+    int threadCount() const;
+
+    /// Converts the blocks [firstBlock, endBlock) in cart, returns when all
+    /// of them are converted with the number of points
+    int convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCartData * cart);
+    /// Same conversion in the arrays of cloud
+    int convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCloud * cloud);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    /// Converts in cart or in cloud, the other one being NULL
+    int convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCartData * cart, VelodyneCloud * cloud);
+    /// Converts the blocks [firstBlock, endBlock) of the conversion in progress
+    int convertRange(int firstBlock, int endBlock) const;
+    /// Waits for the conversions and takes part in them until stop()
+    void workerLoop();
+    /// Converts the chunks not taken yet, returns the number of points
+    int convertChunks();
+
+    const VelodyneConverter & mConverter;
+    std::vector<Worker *> mWorkers;
+    VelodyneThreadSettings mWorkerSettings;
+
+    QMutex mMutex;
+    /// signaled when a conversion starts or when the workers have to stop
+    QWaitCondition mStarted;
+    /// signaled when the last worker leaves a conversion
+    QWaitCondition mFinished;
+    /// incremented for each conversion, protected by mMutex
+    int mGeneration;
+    /// workers converting chunks, protected by mMutex
+    int mBusyWorkers;
+    bool mStopping;
+
+    /// conversion in progress, written under mMutex while no worker is busy
+    const VelodyneBlock * mBlocks;
+    VelodyneCartData * mCart;
+    VelodyneCloud * mCloud;
+    int mEndBlock;
+    int mChunkSize;
+    /// first block of the next chunk to take
+    QAtomicInt mNextBlock;
+    /// points converted by the workers, protected by mMutex
+    int mPointCount;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNECONVERSIONPOOL_H
@@ -0,0 +1,281 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneConverter.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Table-driven conversion of the Velodyne blocks to
+//              Cartesian points
+//
+*********************************************************************/
+
+#include "VelodyneConverter.h"
+#include "VelodyneConverterKernels.h"
+
+#include "kernel/Log.h"
+#include "PacpusTools/geodesie.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace pacpus;
+
+DECLARE_STATIC_LOGGER("pacpus.cityvip.VelodyneConverter");
+
+/// Vertical field of view of the HDL-64S2 divided by its 64 lasers, in degrees
+static const double kFieldOfViewDegrees = 26.8 / 64.0;
+
+/// Unit of the raw distances of the HDL-64S2, in centimeters
+static const double kNominalDistLSB = 0.2;
+
+//////////////////////////////////////////////////////////////////////////
+/// The lasers 0 to 31 are fired in the upper blocks, 32 to 63 in the lower
+/// ones. Without calibration, the vertical angle is supposed to grow by the
+/// field of view divided by 64 from one laser of a block to the next.
+VelodyneCalibration::VelodyneCalibration()
+    : distLSB(kNominalDistLSB)
+{
+    for (int i = 0; i < kLaserCount; ++i) {
+        int iPoint = i % kVelodynePointsPerBlock;
+        double firstAngle = 2.0 - kFieldOfViewDegrees * (i < kVelodynePointsPerBlock ? 32 : 64);
+        rotCorrection[i] = 0;
+        vertCorrection[i] = firstAngle + kFieldOfViewDegrees * iPoint;
+        distCorrection[i] = 0;
+        horizOffsetCorrection[i] = 0;
+        vertOffsetCorrection[i] = 0;
+        minIntensity[i] = 0;
+        maxIntensity[i] = 255;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Constructor, the tables hold the nominal calibration until setCalibration()
+VelodyneConverter::VelodyneConverter()
+    : mKernel(ScalarKernel)
+    , mBlockKernel(convertVelodyneBlockScalar)
+    , mAzimuthCos(kAzimuthCount)
+    , mAzimuthSin(kAzimuthCount)
+{
+    for (int i = 0; i < kAzimuthCount; ++i) {
+        double azimuth = Geodesie::Deg2Rad(i / 100.0);
+        mAzimuthCos[i] = (float) cos(azimuth);
+        mAzimuthSin[i] = (float) sin(azimuth);
+    }
+
+    setCalibration(VelodyneCalibration());
+    setKernel(AutoKernel);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void VelodyneConverter::setCalibration(const VelodyneCalibration & calibration)
+{
+    double distLSB = calibration.distLSB;
+    if (distLSB <= 0) {
+        LOG_WARN("invalid distLSB " << distLSB << ", " << kNominalDistLSB << " cm used");
+        distLSB = kNominalDistLSB;
+    }
+    mTables.distanceUnit = (float) (distLSB / 100.0);
+
+    for (int i = 0; i < kLaserCount; ++i) {
+        double beta = Geodesie::Deg2Rad(calibration.vertCorrection[i]);
+        double rotation = Geodesie::Deg2Rad(calibration.rotCorrection[i]);
+        double vertOffset = calibration.vertOffsetCorrection[i] / 100.0;
+
+        mTables.vertAngle[i] = (float) beta;
+        mTables.cosVert[i] = (float) cos(beta);
+        mTables.sinVert[i] = (float) sin(beta);
+        mTables.cosRot[i] = (float) cos(rotation);
+        mTables.sinRot[i] = (float) sin(rotation);
+        mTables.distCorrection[i] = (float) (calibration.distCorrection[i] / 100.0);
+        mTables.horizOffset[i] = (float) (calibration.horizOffsetCorrection[i] / 100.0);
+        mTables.vertOffsetCos[i] = (float) (vertOffset * cos(beta));
+        mTables.vertOffsetSin[i] = (float) (vertOffset * sin(beta));
+
+        int minIntensity = calibration.minIntensity[i];
+        int maxIntensity = calibration.maxIntensity[i];
+        if (maxIntensity >= minIntensity) {
+            mTables.minIntensity[i] = (float) minIntensity;
+            mTables.maxIntensity[i] = (float) maxIntensity;
+        } else {
+            LOG_WARN("invalid intensity range [" << minIntensity << ", " << maxIntensity << "] of laser " << i
+                     << ", raw intensities used");
+            mTables.minIntensity[i] = 0;
+            mTables.maxIntensity[i] = 255;
+        }
+    }
+    LOG_DEBUG("conversion tables built for " << kLaserCount << " lasers and " << kAzimuthCount << " azimuths");
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool VelodyneConverter::setKernel(Kernel kernel)
+{
+    if (AutoKernel == kernel) {
+        if (velodyneCpuHasAvx2()) {
+            kernel = Avx2Kernel;
+        } else if (velodyneCpuHasSse4()) {
+            kernel = Sse4Kernel;
+        } else {
+            kernel = ScalarKernel;
+        }
+    }
+
+    switch (kernel) {
+    case ScalarKernel:
+        mBlockKernel = convertVelodyneBlockScalar;
+        break;
+#ifdef VELODYNE_HAVE_X86_KERNELS
+    case Sse4Kernel:
+        if (!velodyneCpuHasSse4()) {
+            return false;
+        }
+        mBlockKernel = convertVelodyneBlockSse4;
+        break;
+    case Avx2Kernel:
+        if (!velodyneCpuHasAvx2()) {
+            return false;
+        }
+        mBlockKernel = convertVelodyneBlockAvx2;
+        break;
+#endif
+    default:
+        return false;
+    }
+    mKernel = kernel;
+    LOG_DEBUG("conversion kernel " << kernelName(mKernel));
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+VelodyneConverter::Kernel VelodyneConverter::kernel() const
+{
+    return mKernel;
+}
+
+//////////////////////////////////////////////////////////////////////////
+const char * VelodyneConverter::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case AutoKernel:
+        return "auto";
+    case ScalarKernel:
+        return "scalar";
+    case Sse4Kernel:
+        return "sse4";
+    case Avx2Kernel:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneConverter::convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCartData * cart) const
+{
+    int pointCountTotal = 0;
+
+    for (int block = firstBlock; block < endBlock; ++block) {
+        const VelodyneBlock & polarBlock = blocks[block];
+        VelodyneCartBlock & cartBlock = cart->Data[block];
+
+        const int laser = firstLaser(polarBlock.block);
+        if (laser < 0) {
+            LOG_WARN("invalid signature in block " << block << ", signature = " << polarBlock.block);
+            cartBlock.block = polarBlock.block;
+            continue;
+        }
+
+        int azimuth = polarBlock.angle;
+        if (azimuth >= kAzimuthCount) {
+            azimuth %= kAzimuthCount;
+        }
+        cartBlock.alpha = (float) Geodesie::Deg2Rad(azimuth / 100.0);
+        cartBlock.beta = mTables.vertAngle[laser];
+        cartBlock.block = polarBlock.block;
+
+        pointCountTotal += convertBlock(polarBlock, laser, azimuth, cartBlock);
+    }
+    return pointCountTotal;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The arrays computed by the kernel are copied as they are in the cloud
+int VelodyneConverter::convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCloud * cloud) const
+{
+    int pointCountTotal = 0;
+    const size_t blockBytes = kVelodynePointsPerBlock * sizeof(float);
+
+    for (int block = firstBlock; block < endBlock; ++block) {
+        const VelodyneBlock & polarBlock = blocks[block];
+        const int offset = block * kVelodynePointsPerBlock;
+
+        const int laser = firstLaser(polarBlock.block);
+        if (laser < 0) {
+            LOG_WARN("invalid signature in block " << block << ", signature = " << polarBlock.block);
+            memset(cloud->x + offset, 0, blockBytes);
+            memset(cloud->y + offset, 0, blockBytes);
+            memset(cloud->z + offset, 0, blockBytes);
+            memset(cloud->intensity + offset, 0, blockBytes);
+            memset(cloud->distance + offset, 0, blockBytes);
+            memset(cloud->valid + offset, 0, kVelodynePointsPerBlock);
+            memset(cloud->laser + offset, 0, kVelodynePointsPerBlock);
+            memset(cloud->azimuth + offset, 0, kVelodynePointsPerBlock * sizeof(uint16_t));
+            continue;
+        }
+
+        int azimuth = polarBlock.angle;
+        if (azimuth >= kAzimuthCount) {
+            azimuth %= kAzimuthCount;
+        }
+
+        VelodyneBlockPoints points;
+        mBlockKernel(mTables, laser, mAzimuthCos[azimuth], mAzimuthSin[azimuth], polarBlock.rawPoints, &points);
+        memcpy(cloud->x + offset, points.x, blockBytes);
+        memcpy(cloud->y + offset, points.y, blockBytes);
+        memcpy(cloud->z + offset, points.z, blockBytes);
+        memcpy(cloud->intensity + offset, points.intensity, blockBytes);
+        memcpy(cloud->distance + offset, points.distance, blockBytes);
+        for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+            const uint8_t valid = (uint8_t) points.valid[iPoint];
+            cloud->valid[offset + iPoint] = valid;
+            cloud->laser[offset + iPoint] = (uint8_t) (laser + iPoint);
+            cloud->azimuth[offset + iPoint] = (uint16_t) azimuth;
+            pointCountTotal += valid;
+        }
+    }
+    return pointCountTotal;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int VelodyneConverter::firstLaser(uint16_t signature)
+{
+    switch (signature) {
+    case kVelodyneUpperBlock:
+        return 0;
+    case kVelodyneLowerBlock:
+        return kVelodynePointsPerBlock;
+    default:
+        return -1;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The kernel computes the points into arrays, they are then stored in the
+/// packed VelodyneCartPoint
+int VelodyneConverter::convertBlock(const VelodyneBlock & polarBlock, int firstLaser, int azimuth, VelodyneCartBlock & cartBlock) const
+{
+    VelodyneBlockPoints points;
+    mBlockKernel(mTables, firstLaser, mAzimuthCos[azimuth], mAzimuthSin[azimuth], polarBlock.rawPoints, &points);
+
+    int pointCount = 0;
+    for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+        VelodyneCartPoint & point = cartBlock.Points[iPoint];
+        point.distance = points.distance[iPoint];
+        point.X = points.x[iPoint];
+        point.Y = points.y[iPoint];
+        point.Z = points.z[iPoint];
+        point.intensity = (unsigned char) (points.intensity[iPoint] + 0.5f);
+        pointCount += (int) points.valid[iPoint];
+    }
+    return pointCount;
+}
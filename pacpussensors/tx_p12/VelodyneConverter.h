@@ -0,0 +1,131 @@
+/// @file
+/// Table-driven conversion of the Velodyne blocks to Cartesian points
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNECONVERTER_H
+#define VELODYNECONVERTER_H
+
+#include <vector>
+
+#include "kernel/road_time.h"
+#include "../VelodyneComponent/structure_velodyne.h"
+#include "structure_velodyne_cart.h"
+#include "VelodyneCloud.h"
+
+namespace pacpus {
+
+/// Calibration of the lasers as read from db.xml, angles in degrees and
+/// lengths in centimeters. Laser i is the i-th point of the upper blocks for
+/// i < 32 and the (i - 32)-th point of the lower blocks otherwise.
+struct VelodyneCalibration
+{
+    static const int kLaserCount = 64;
+
+    /// Nominal HDL-64S2: no correction and a linear vertical fan
+    VelodyneCalibration();
+
+    double rotCorrection[kLaserCount];
+    double vertCorrection[kLaserCount];
+    double distCorrection[kLaserCount];
+    double horizOffsetCorrection[kLaserCount];
+    double vertOffsetCorrection[kLaserCount];
+    /// range the raw intensities are clamped to
+    int minIntensity[kLaserCount];
+    int maxIntensity[kLaserCount];
+    /// unit of the raw distances
+    double distLSB;
+};
+
+/// Constants of the lasers computed from a VelodyneCalibration, lengths in
+/// meters. There is one array per constant rather than one structure per
+/// laser, so that the constants of the 32 lasers of a block are contiguous
+/// and are loaded by a vectorized loop like the points themselves.
+struct VelodyneLaserTables
+{
+    static const int kLaserCount = VelodyneCalibration::kLaserCount;
+
+    float cosVert[kLaserCount];
+    float sinVert[kLaserCount];
+    /// rotation correction, subtracted from the azimuth
+    float cosRot[kLaserCount];
+    float sinRot[kLaserCount];
+    float distCorrection[kLaserCount];
+    float horizOffset[kLaserCount];
+    /// vertical offset times the cosine and the sine of the vertical angle
+    float vertOffsetCos[kLaserCount];
+    float vertOffsetSin[kLaserCount];
+    /// intensity = raw clamped to [minIntensity, maxIntensity]
+    float minIntensity[kLaserCount];
+    float maxIntensity[kLaserCount];
+    /// vertical angle in radians, given as the elevation of the blocks
+    float vertAngle[kLaserCount];
+    /// distLSB in meters
+    float distanceUnit;
+};
+
+struct VelodyneBlockPoints;
+
+/// Converts the polar blocks of a revolution into a VelodyneCartData.
+///
+/// Everything that only depends on the laser is computed once by
+/// setCalibration() into a VelodyneLaserTables. The cosine and sine of the
+/// 36000 azimuths are tabulated as well, so that converting a point only
+/// takes multiplications and additions, without any branch.
+///
+/// The points of a block are computed by a kernel chosen at run time among
+/// those the processor supports, the scalar one being the reference.
+class VelodyneConverter
+{
+public:
+    static const int kLaserCount = VelodyneCalibration::kLaserCount;
+    /// azimuths of the blocks, in hundredths of degree
+    static const int kAzimuthCount = 36000;
+
+    /// Implementations of the conversion of a block
+    enum Kernel {
+        /// the fastest one supported by the processor
+        AutoKernel,
+        /// reference, one point at a time
+        ScalarKernel,
+        /// 4 points at a time, x86 only
+        Sse4Kernel,
+        /// 8 points at a time, x86 only
+        Avx2Kernel
+    };
+
+    VelodyneConverter();
+
+    /// Builds the tables from the calibration of the sensor
+    void setCalibration(const VelodyneCalibration & calibration);
+
+    /// Returns false, keeping the current kernel, if the processor or the build does not support kernel
+    bool setKernel(Kernel kernel);
+    /// Kernel in use, never AutoKernel
+    Kernel kernel() const;
+    static const char * kernelName(Kernel kernel);
+
+    /// Converts the blocks [firstBlock, endBlock) in cart and returns the number of points.
+    /// The points without return get a null distance and null coordinates.
+    int convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCartData * cart) const;
+    /// Same conversion in the arrays of cloud, the points of the blocks with an invalid signature are cleared
+    int convert(const VelodyneBlock * blocks, int firstBlock, int endBlock, VelodyneCloud * cloud) const;
+
+private:
+    /// First laser of the upper or lower blocks, -1 for an invalid signature
+    static int firstLaser(uint16_t signature);
+    /// Converts the 32 points of a block fired by the lasers [firstLaser, firstLaser + 32)
+    int convertBlock(const VelodyneBlock & polarBlock, int firstLaser, int azimuth, VelodyneCartBlock & cartBlock) const;
+
+    VelodyneLaserTables mTables;
+    Kernel mKernel;
+    void (*mBlockKernel)(const VelodyneLaserTables &, int, float, float, const VelodyneRawPoint *, VelodyneBlockPoints *);
+    std::vector<float> mAzimuthCos;
+    std::vector<float> mAzimuthSin;
+};
+
+} // namespace pacpus
+
+#endif // VELODYNECONVERTER_H
@@ -0,0 +1,100 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneConverterAvx2.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    AVX2 kernel of the conversion of the Velodyne blocks,
+//              built with the AVX2 instructions enabled
+//
+*********************************************************************/
+
+#include "VelodyneConverterKernels.h"
+
+#ifdef VELODYNE_HAVE_X86_KERNELS
+
+#include <immintrin.h>
+
+using namespace pacpus;
+
+//////////////////////////////////////////////////////////////////////////
+/// Converts the points [iPoint, iPoint + 8) whose raw distances and
+/// intensities are in the lanes, with the operations of the scalar kernel
+static inline void convertLanes(const VelodyneLaserTables & tables, int laser, int iPoint,
+                                __m256 rawDistance, __m256 rawIntensity,
+                                __m256 cosAzimuth, __m256 sinAzimuth, __m256 distanceUnit,
+                                VelodyneBlockPoints * points)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 v = _mm256_and_ps(_mm256_cmp_ps(rawDistance, zero, _CMP_NEQ_UQ), _mm256_set1_ps(1.0f));
+    const __m256 cosVert = _mm256_loadu_ps(tables.cosVert + laser);
+    const __m256 sinVert = _mm256_loadu_ps(tables.sinVert + laser);
+    const __m256 cosRot = _mm256_loadu_ps(tables.cosRot + laser);
+    const __m256 sinRot = _mm256_loadu_ps(tables.sinRot + laser);
+
+    const __m256 d = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(rawDistance, distanceUnit),
+                                                 _mm256_loadu_ps(tables.distCorrection + laser)), v);
+    const __m256 cosAngle = _mm256_add_ps(_mm256_mul_ps(cosAzimuth, cosRot), _mm256_mul_ps(sinAzimuth, sinRot));
+    const __m256 sinAngle = _mm256_sub_ps(_mm256_mul_ps(sinAzimuth, cosRot), _mm256_mul_ps(cosAzimuth, sinRot));
+    const __m256 dxy = _mm256_sub_ps(_mm256_mul_ps(d, cosVert), _mm256_mul_ps(_mm256_loadu_ps(tables.vertOffsetSin + laser), v));
+    const __m256 h = _mm256_mul_ps(_mm256_loadu_ps(tables.horizOffset + laser), v);
+
+    _mm256_storeu_ps(points->valid + iPoint, v);
+    _mm256_storeu_ps(points->distance + iPoint, d);
+    _mm256_storeu_ps(points->x + iPoint, _mm256_sub_ps(_mm256_mul_ps(dxy, sinAngle), _mm256_mul_ps(h, cosAngle)));
+    _mm256_storeu_ps(points->y + iPoint, _mm256_add_ps(_mm256_mul_ps(dxy, cosAngle), _mm256_mul_ps(h, sinAngle)));
+    _mm256_storeu_ps(points->z + iPoint, _mm256_add_ps(_mm256_mul_ps(d, sinVert),
+                                                       _mm256_mul_ps(_mm256_loadu_ps(tables.vertOffsetCos + laser), v)));
+    _mm256_storeu_ps(points->intensity + iPoint, _mm256_min_ps(_mm256_max_ps(rawIntensity, _mm256_loadu_ps(tables.minIntensity + laser)),
+                                                               _mm256_loadu_ps(tables.maxIntensity + laser)));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The byte shuffles of AVX2 stay within each 128-bit half: the 12 bytes of
+/// the points [iPoint, iPoint + 4) are loaded in the low half, those of
+/// [iPoint + 4, iPoint + 8) in the high half, then spread as by the SSE4.1
+/// kernel. The last 4 points are loaded 4 bytes earlier, so that nothing is
+/// read past the block.
+void pacpus::convertVelodyneBlockAvx2(const VelodyneLaserTables & tables, int firstLaser,
+                                      float cosAzimuth, float sinAzimuth,
+                                      const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points)
+{
+    const char * raw = reinterpret_cast<const char *>(rawPoints);
+    const __m256i distanceShuffle = _mm256_setr_epi8(
+                0, 1, -1, -1, 3, 4, -1, -1, 6, 7, -1, -1, 9, 10, -1, -1,
+                0, 1, -1, -1, 3, 4, -1, -1, 6, 7, -1, -1, 9, 10, -1, -1);
+    const __m256i intensityShuffle = _mm256_setr_epi8(
+                2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1,
+                2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+    const __m256i lastDistanceShuffle = _mm256_setr_epi8(
+                0, 1, -1, -1, 3, 4, -1, -1, 6, 7, -1, -1, 9, 10, -1, -1,
+                4, 5, -1, -1, 7, 8, -1, -1, 10, 11, -1, -1, 13, 14, -1, -1);
+    const __m256i lastIntensityShuffle = _mm256_setr_epi8(
+                2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1,
+                6, -1, -1, -1, 9, -1, -1, -1, 12, -1, -1, -1, 15, -1, -1, -1);
+    const __m256 cosA = _mm256_set1_ps(cosAzimuth);
+    const __m256 sinA = _mm256_set1_ps(sinAzimuth);
+    const __m256 distanceUnit = _mm256_set1_ps(tables.distanceUnit);
+
+    const int lastGroup = kVelodynePointsPerBlock - 8;
+    for (int iPoint = 0; iPoint < lastGroup; iPoint += 8) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + 3 * iPoint));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + 3 * iPoint + 12));
+        const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        convertLanes(tables, firstLaser + iPoint, iPoint,
+                     _mm256_cvtepi32_ps(_mm256_shuffle_epi8(bytes, distanceShuffle)),
+                     _mm256_cvtepi32_ps(_mm256_shuffle_epi8(bytes, intensityShuffle)),
+                     cosA, sinA, distanceUnit, points);
+    }
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + 3 * lastGroup));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + 3 * lastGroup + 12 - 4));
+    const __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    convertLanes(tables, firstLaser + lastGroup, lastGroup,
+                 _mm256_cvtepi32_ps(_mm256_shuffle_epi8(bytes, lastDistanceShuffle)),
+                 _mm256_cvtepi32_ps(_mm256_shuffle_epi8(bytes, lastIntensityShuffle)),
+                 cosA, sinA, distanceUnit, points);
+}
+
+#endif // VELODYNE_HAVE_X86_KERNELS
@@ -0,0 +1,116 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneConverterKernels.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Reference kernel of the conversion of the Velodyne
+//              blocks and detection of the SIMD instruction sets
+//
+*********************************************************************/
+
+#include "VelodyneConverterKernels.h"
+
+#include <algorithm>
+
+#if defined(VELODYNE_HAVE_X86_KERNELS) && defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+using namespace pacpus;
+
+//////////////////////////////////////////////////////////////////////////
+/// The angle of a point is its azimuth minus the rotation correction of its
+/// laser, whose cosine and sine come from the tables:
+/// cos(a - r) = cos a cos r + sin a sin r, sin(a - r) = sin a cos r - cos a sin r
+///
+/// The SIMD kernels do the same operations in the same order, so that their
+/// results are identical as long as the compiler does not contract them.
+void pacpus::convertVelodyneBlockScalar(const VelodyneLaserTables & tables, int firstLaser,
+                                        float cosAzimuth, float sinAzimuth,
+                                        const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points)
+{
+    const float distanceUnit = tables.distanceUnit;
+    const float * cosVert = tables.cosVert + firstLaser;
+    const float * sinVert = tables.sinVert + firstLaser;
+    const float * cosRot = tables.cosRot + firstLaser;
+    const float * sinRot = tables.sinRot + firstLaser;
+    const float * distCorrection = tables.distCorrection + firstLaser;
+    const float * horizOffset = tables.horizOffset + firstLaser;
+    const float * vertOffsetCos = tables.vertOffsetCos + firstLaser;
+    const float * vertOffsetSin = tables.vertOffsetSin + firstLaser;
+    const float * minIntensity = tables.minIntensity + firstLaser;
+    const float * maxIntensity = tables.maxIntensity + firstLaser;
+
+    // the raw points are packed by 3 bytes, they are spread into arrays first
+    float rawDistance[kVelodynePointsPerBlock];
+    float rawIntensity[kVelodynePointsPerBlock];
+    for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+        rawDistance[iPoint] = rawPoints[iPoint].distance;
+        rawIntensity[iPoint] = rawPoints[iPoint].intensity;
+    }
+
+    for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+        // 0 for a point at scanner, which ends up at the origin
+        const float v = (rawDistance[iPoint] != 0.0f) ? 1.0f : 0.0f;
+        const float d = (rawDistance[iPoint] * distanceUnit + distCorrection[iPoint]) * v;
+        const float cosAngle = cosAzimuth * cosRot[iPoint] + sinAzimuth * sinRot[iPoint];
+        const float sinAngle = sinAzimuth * cosRot[iPoint] - cosAzimuth * sinRot[iPoint];
+        const float dxy = d * cosVert[iPoint] - vertOffsetSin[iPoint] * v;
+        const float h = horizOffset[iPoint] * v;
+
+        points->valid[iPoint] = v;
+        points->distance[iPoint] = d;
+        points->x[iPoint] = dxy * sinAngle - h * cosAngle;
+        points->y[iPoint] = dxy * cosAngle + h * sinAngle;
+        points->z[iPoint] = d * sinVert[iPoint] + vertOffsetCos[iPoint] * v;
+        // same operand order as minps and maxps
+        points->intensity[iPoint] = std::min(maxIntensity[iPoint], std::max(minIntensity[iPoint], rawIntensity[iPoint]));
+    }
+}
+
+#if defined(VELODYNE_HAVE_X86_KERNELS) && defined(_MSC_VER)
+//////////////////////////////////////////////////////////////////////////
+/// AVX needs the operating system to save the YMM registers
+static bool osSavesYmmRegisters()
+{
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = 0 != (info[2] & (1 << 27));
+    const bool avx = 0 != (info[2] & (1 << 28));
+    return osxsave && avx && (6 == (_xgetbv(0) & 6));
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+bool pacpus::velodyneCpuHasSse4()
+{
+#if !defined(VELODYNE_HAVE_X86_KERNELS)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return 0 != (info[2] & (1 << 19));
+#else
+    return 0 != __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+bool pacpus::velodyneCpuHasAvx2()
+{
+#if !defined(VELODYNE_HAVE_X86_KERNELS)
+    return false;
+#elif defined(_MSC_VER)
+    if (!osSavesYmmRegisters()) {
+        return false;
+    }
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return 0 != (info[1] & (1 << 5));
+#else
+    return 0 != __builtin_cpu_supports("avx2");
+#endif
+}
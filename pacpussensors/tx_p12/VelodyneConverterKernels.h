@@ -0,0 +1,57 @@
+/// @file
+/// Kernels converting the 32 points of a Velodyne block, scalar and SIMD
+///
+/// @date created   2026/10/16
+/// @copyright      Heudiasyc UMR UTC/CNRS 6599
+/// @version        $Id: $
+
+#ifndef VELODYNECONVERTERKERNELS_H
+#define VELODYNECONVERTERKERNELS_H
+
+#include "VelodyneConverter.h"
+
+namespace pacpus {
+
+/// Points of a block computed by a kernel, one array per field. The points
+/// without return have a null validity, distance and coordinates.
+struct VelodyneBlockPoints
+{
+    /// 1 for a return, 0 for a point at scanner
+    float valid[kVelodynePointsPerBlock];
+    float distance[kVelodynePointsPerBlock];
+    float x[kVelodynePointsPerBlock];
+    float y[kVelodynePointsPerBlock];
+    float z[kVelodynePointsPerBlock];
+    /// calibrated intensity in [0, 255]
+    float intensity[kVelodynePointsPerBlock];
+};
+
+/// Converts the raw points of a block fired by the lasers [firstLaser, firstLaser + 32),
+/// at the azimuth whose cosine and sine are given
+typedef void (*VelodyneBlockKernel)(const VelodyneLaserTables & tables, int firstLaser,
+                                    float cosAzimuth, float sinAzimuth,
+                                    const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points);
+
+/// Reference kernel, available everywhere
+void convertVelodyneBlockScalar(const VelodyneLaserTables & tables, int firstLaser,
+                                float cosAzimuth, float sinAzimuth,
+                                const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points);
+
+#ifdef VELODYNE_HAVE_X86_KERNELS
+/// 4 points per instruction, only called when velodyneCpuHasSse4() is true
+void convertVelodyneBlockSse4(const VelodyneLaserTables & tables, int firstLaser,
+                              float cosAzimuth, float sinAzimuth,
+                              const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points);
+/// 8 points per instruction, only called when velodyneCpuHasAvx2() is true
+void convertVelodyneBlockAvx2(const VelodyneLaserTables & tables, int firstLaser,
+                              float cosAzimuth, float sinAzimuth,
+                              const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points);
+#endif // VELODYNE_HAVE_X86_KERNELS
+
+/// Instruction sets of the processor running the program
+bool velodyneCpuHasSse4();
+bool velodyneCpuHasAvx2();
+
+} // namespace pacpus
+
+#endif // VELODYNECONVERTERKERNELS_H
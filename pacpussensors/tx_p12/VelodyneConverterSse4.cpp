@@ -0,0 +1,87 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   VelodyneConverterSse4.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    SSE4.1 kernel of the conversion of the Velodyne blocks,
+//              built with the SSE4.1 instructions enabled
+//
+*********************************************************************/
+
+#include "VelodyneConverterKernels.h"
+
+#ifdef VELODYNE_HAVE_X86_KERNELS
+
+#include <smmintrin.h>
+
+using namespace pacpus;
+
+//////////////////////////////////////////////////////////////////////////
+/// Converts the points [iPoint, iPoint + 4) whose raw distances and
+/// intensities are in the lanes, with the operations of the scalar kernel
+static inline void convertLanes(const VelodyneLaserTables & tables, int laser, int iPoint,
+                                __m128 rawDistance, __m128 rawIntensity,
+                                __m128 cosAzimuth, __m128 sinAzimuth, __m128 distanceUnit,
+                                VelodyneBlockPoints * points)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 v = _mm_and_ps(_mm_cmpneq_ps(rawDistance, zero), _mm_set1_ps(1.0f));
+    const __m128 cosVert = _mm_loadu_ps(tables.cosVert + laser);
+    const __m128 sinVert = _mm_loadu_ps(tables.sinVert + laser);
+    const __m128 cosRot = _mm_loadu_ps(tables.cosRot + laser);
+    const __m128 sinRot = _mm_loadu_ps(tables.sinRot + laser);
+
+    const __m128 d = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rawDistance, distanceUnit),
+                                           _mm_loadu_ps(tables.distCorrection + laser)), v);
+    const __m128 cosAngle = _mm_add_ps(_mm_mul_ps(cosAzimuth, cosRot), _mm_mul_ps(sinAzimuth, sinRot));
+    const __m128 sinAngle = _mm_sub_ps(_mm_mul_ps(sinAzimuth, cosRot), _mm_mul_ps(cosAzimuth, sinRot));
+    const __m128 dxy = _mm_sub_ps(_mm_mul_ps(d, cosVert), _mm_mul_ps(_mm_loadu_ps(tables.vertOffsetSin + laser), v));
+    const __m128 h = _mm_mul_ps(_mm_loadu_ps(tables.horizOffset + laser), v);
+
+    _mm_storeu_ps(points->valid + iPoint, v);
+    _mm_storeu_ps(points->distance + iPoint, d);
+    _mm_storeu_ps(points->x + iPoint, _mm_sub_ps(_mm_mul_ps(dxy, sinAngle), _mm_mul_ps(h, cosAngle)));
+    _mm_storeu_ps(points->y + iPoint, _mm_add_ps(_mm_mul_ps(dxy, cosAngle), _mm_mul_ps(h, sinAngle)));
+    _mm_storeu_ps(points->z + iPoint, _mm_add_ps(_mm_mul_ps(d, sinVert),
+                                                 _mm_mul_ps(_mm_loadu_ps(tables.vertOffsetCos + laser), v)));
+    _mm_storeu_ps(points->intensity + iPoint, _mm_min_ps(_mm_max_ps(rawIntensity, _mm_loadu_ps(tables.minIntensity + laser)),
+                                                         _mm_loadu_ps(tables.maxIntensity + laser)));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// The 12 bytes of 4 raw points are loaded in one register and spread by
+/// byte shuffles: the distances into the low half of 4 integers, the
+/// intensities into their low byte. The last 4 points are loaded 4 bytes
+/// earlier, so that nothing is read past the block.
+void pacpus::convertVelodyneBlockSse4(const VelodyneLaserTables & tables, int firstLaser,
+                                      float cosAzimuth, float sinAzimuth,
+                                      const VelodyneRawPoint * rawPoints, VelodyneBlockPoints * points)
+{
+    const char * raw = reinterpret_cast<const char *>(rawPoints);
+    const __m128i distanceShuffle = _mm_setr_epi8(0, 1, -1, -1, 3, 4, -1, -1, 6, 7, -1, -1, 9, 10, -1, -1);
+    const __m128i intensityShuffle = _mm_setr_epi8(2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1);
+    const __m128i lastDistanceShuffle = _mm_setr_epi8(4, 5, -1, -1, 7, 8, -1, -1, 10, 11, -1, -1, 13, 14, -1, -1);
+    const __m128i lastIntensityShuffle = _mm_setr_epi8(6, -1, -1, -1, 9, -1, -1, -1, 12, -1, -1, -1, 15, -1, -1, -1);
+    const __m128 cosA = _mm_set1_ps(cosAzimuth);
+    const __m128 sinA = _mm_set1_ps(sinAzimuth);
+    const __m128 distanceUnit = _mm_set1_ps(tables.distanceUnit);
+
+    const int lastGroup = kVelodynePointsPerBlock - 4;
+    for (int iPoint = 0; iPoint < lastGroup; iPoint += 4) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + 3 * iPoint));
+        convertLanes(tables, firstLaser + iPoint, iPoint,
+                     _mm_cvtepi32_ps(_mm_shuffle_epi8(bytes, distanceShuffle)),
+                     _mm_cvtepi32_ps(_mm_shuffle_epi8(bytes, intensityShuffle)),
+                     cosA, sinA, distanceUnit, points);
+    }
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(raw + 3 * lastGroup - 4));
+    convertLanes(tables, firstLaser + lastGroup, lastGroup,
+                 _mm_cvtepi32_ps(_mm_shuffle_epi8(bytes, lastDistanceShuffle)),
+                 _mm_cvtepi32_ps(_mm_shuffle_epi8(bytes, lastIntensityShuffle)),
+                 cosA, sinA, distanceUnit, points);
+}
+
+#endif // VELODYNE_HAVE_X86_KERNELS
@@ -9,11 +9,12 @@
 
 #include "kernel/ComponentFactory.h"
 #include "kernel/Log.h"
-#include "PacpusTools/geodesie.h"
 #include "PacpusTools/ShMem.h"
+#include "../VelodyneComponent/VelodyneCompactScan.h"
 
 #include <boost/current_function.hpp>
 #include <cmath>
+#include <cstring>
 #include <QFile>
 #include <QTimer>
 #include <vector>
@@ -27,14 +28,39 @@ DECLARE_STATIC_LOGGER("pacpus.cityvip.VelodyneInterface");
 const char * VelodyneInterface::COMPONENT_NAME = "VelodyneInterface";
 const char * VelodyneInterface::COMPONENT_XML_NAME = "VelodyneInterface";
 const char * VelodyneInterface::SHARED_MEMORY_NAME = "VELODYNE";
+const char * VelodyneInterface::SECTOR_SHARED_MEMORY_SUFFIX = "_SECTORS";
 
 const unsigned kMaxWaitForThreadTimeMs = 5000;
 
+/// Time without revolution after which a lidar timeout is reported, 10 revolutions at 10 Hz
+const unsigned long kScanTimeoutMs = 1000;
+
+/// Upper bound of the conversionThreads property
+const int kMaxConversionThreads = 64;
+
+/// Highest core number accepted for the threadCore property, the size of a Linux cpu_set_t
+const int kMaxCore = 1023;
+
 /// Construct the factory
 static ComponentFactory<VelodyneInterface> sFactory(VelodyneInterface::COMPONENT_NAME);
 
 VelodyneInterface::VelodyneInterface(QString name)
     : ComponentBase(name)
+    , sectors_(false)
+    , conversionThreads_(1)
+    , conversionPool_(converter_)
+    , shmem_(NULL)
+    , shmemSlots_(kVelodyneScanRingDefaultSlots)
+    , readLatest_(true)
+    , missedCount_(0)
+    , wakeCount_(0)
+    , wakeLatencySum_(0)
+    , maxWakeLatency_(0)
+    , cloudFormat_(XyziCloud)
+    , velodyneData_(NULL)
+    , velodyneCartData_(NULL)
+    , velodyneCloud_(NULL)
+    , velodyneComputingStrategy(NULL)
 {
     LOG_TRACE("constructor(" << name <<")");
 }
@@ -53,17 +79,140 @@ VelodyneInterface::configureComponent(XmlComponentConfig /* config */)
     //Load Xml parameters
     //recording_ = (param.getProperty("output_file") == "true" ? true : false);
     //dbt2txt_ = (param.getProperty("output_dbt2txt") == "true" ? true : false);
+    sectors_ = (param.getProperty("sectors") == "true" ? true : false);
+    // shared memory of the VelodyneComponent to read, when several sensors are acquired
+    shmemName_ = SHARED_MEMORY_NAME;
+    if (!param.getProperty("shmem").isEmpty()) {
+        shmemName_ = param.getProperty("shmem");
+    }
+    LOG_INFO("property shmem=\"" << shmemName_ << "\"");
+    if (!readIntegerProperty("shmemSlots", 1, kVelodyneScanRingMaxSlots, &shmemSlots_)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+    // jump to the newest revolution instead of converting every revolution in order
+    readLatest_ = (param.getProperty("readLatest") == "false" ? false : true);
+    LOG_INFO("property readLatest=\"" << readLatest_ << "\"");
+    // ring where the converted revolutions are published for the other processes, with shmemSlots slots
+    cloudShmemName_ = param.getProperty("cloudShmem");
+    if (!cloudShmemName_.isEmpty()) {
+        LOG_INFO("property cloudShmem=\"" << cloudShmemName_ << "\"");
+    }
+    QString cloudFormat = param.getProperty("cloudFormat");
+    if (!cloudFormat.isNull()) {
+        if ("xyzi" == cloudFormat) {
+            cloudFormat_ = XyziCloud;
+        } else if ("cart" == cloudFormat) {
+            cloudFormat_ = CartesianCloud;
+        } else {
+            LOG_ERROR("unknown cloud format '" << cloudFormat << "', expected 'xyzi' or 'cart'");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property cloudFormat=\"" << (XyziCloud == cloudFormat_ ? "xyzi" : "cart") << "\"");
+    // implementation of the conversion, the fastest one the processor supports by default
+    QString conversionKernel = param.getProperty("conversionKernel");
+    if (!conversionKernel.isNull()) {
+        VelodyneConverter::Kernel kernel;
+        if ("auto" == conversionKernel) {
+            kernel = VelodyneConverter::AutoKernel;
+        } else if ("scalar" == conversionKernel) {
+            kernel = VelodyneConverter::ScalarKernel;
+        } else if ("sse4" == conversionKernel) {
+            kernel = VelodyneConverter::Sse4Kernel;
+        } else if ("avx2" == conversionKernel) {
+            kernel = VelodyneConverter::Avx2Kernel;
+        } else {
+            LOG_ERROR("unknown conversion kernel '" << conversionKernel << "', expected 'auto', 'scalar', 'sse4' or 'avx2'");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+        if (!converter_.setKernel(kernel)) {
+            LOG_ERROR("conversion kernel '" << conversionKernel << "' not supported by this processor");
+            return ComponentBase::CONFIGURED_FAILED;
+        }
+    }
+    LOG_INFO("property conversionKernel=\"" << VelodyneConverter::kernelName(converter_.kernel()) << "\"");
+    // threads converting the blocks of a revolution, in azimuth sectors
+    if (!readIntegerProperty("conversionThreads", 1, kMaxConversionThreads, &conversionThreads_)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+    // huge pages and locking of the revolution buffers and of the shared memory
+    memorySettings_.hugePages = (param.getProperty("hugePages") == "true" ? true : false);
+    memorySettings_.lock = (param.getProperty("lockMemory") == "true" ? true : false);
+    LOG_INFO("property hugePages=\"" << memorySettings_.hugePages << "\" lockMemory=\"" << memorySettings_.lock << "\"");
+    // placement and SCHED_FIFO priority of the conversion thread
+    if (!readIntegerProperty("threadCore", kVelodyneAnyCore, kMaxCore, &threadSettings_.core)
+            || !readIntegerProperty("threadPriority", 0, 99, &threadSettings_.priority)) {
+        return ComponentBase::CONFIGURED_FAILED;
+    }
+    LOG_INFO("property sectors=\"" << sectors_ << "\"");
 
     return ComponentBase::CONFIGURED_OK;
 }
 
+/// Reads an integer property between min and max. The value is left
+/// unchanged if the property is absent.
+bool VelodyneInterface::readIntegerProperty(const string & name, int min, int max, int * value)
+{
+    QString text = param.getProperty(name.c_str());
+    if (!text.isNull()) {
+        bool ok;
+        int v = text.toInt(&ok);
+        if (!ok || (v < min) || (v > max)) {
+            LOG_ERROR("invalid property " << name << "=\"" << text << "\", expected " << min << " to " << max);
+            return false;
+        }
+        *value = v;
+    }
+    LOG_INFO("property " << name << "=\"" << *value << "\"");
+    return true;
+}
+
 void VelodyneInterface::startActivity()
 {
     LOG_TRACE(BOOST_CURRENT_FUNCTION);
 
-    LOG_DEBUG("creating shared memory for Velodyne, size = " << sizeof(VelodynePolarData));
+    // allocate and prefault the revolution buffers
+    if (!velodyneDataBuffer_.allocate(sizeof(VelodynePolarData), memorySettings_)
+            || !velodyneCartDataBuffer_.allocate(sizeof(VelodyneCartData), memorySettings_)) {
+        LOG_ERROR("cannot allocate the Velodyne buffers");
+        return;
+    }
+    velodyneData_ = static_cast<VelodynePolarData *>(velodyneDataBuffer_.data());
+    velodyneCartData_ = static_cast<VelodyneCartData *>(velodyneCartDataBuffer_.data());
+
     // initialize shared memory
-    shmem_ = new ShMem(VelodyneInterface::SHARED_MEMORY_NAME, sizeof(VelodynePolarData));
+    if (sectors_) {
+        LOG_DEBUG("creating shared memory for Velodyne sectors, size = " << VELODYNE_SECTOR_MAX_RECORD_SIZE);
+        shmem_ = new ShMem((shmemName_ + SECTOR_SHARED_MEMORY_SUFFIX).toStdString().c_str(), VELODYNE_SECTOR_MAX_RECORD_SIZE);
+    } else {
+        LOG_DEBUG("opening the ring of " << shmemSlots_ << " Velodyne revolutions");
+        if (!scanRecord_.allocate(sizeof(VelodynePolarData), memorySettings_)) {
+            LOG_ERROR("cannot allocate the Velodyne buffers");
+            return;
+        }
+        missedCount_ = 0;
+        wakeCount_ = 0;
+        wakeLatencySum_ = 0;
+        maxWakeLatency_ = 0;
+        if (!scanRing_.open(shmemName_.toStdString(), shmemSlots_, sizeof(VelodynePolarData), memorySettings_)) {
+            LOG_ERROR("cannot open the Velodyne shared memory");
+            return;
+        }
+    }
+
+    if (!cloudShmemName_.isEmpty()) {
+        int cloudSize = (XyziCloud == cloudFormat_) ? (int) VELODYNE_CLOUD_MAX_RECORD_SIZE : (int) sizeof(VelodyneCartData);
+        if (!cloudRing_.open(cloudShmemName_.toStdString(), shmemSlots_, cloudSize, memorySettings_)) {
+            LOG_ERROR("cannot publish the Velodyne clouds");
+        }
+    }
+
+    if ((NULL != velodyneComputingStrategy) && velodyneComputingStrategy->usesCloud()) {
+        allocateCloud();
+    }
+
+    // the workers share the priority of the conversion thread
+    conversionPool_.start(conversionThreads_, threadSettings_);
 
     // set thread state to alive
     VelodyneInterface::m_isThreadAlive = true;
@@ -87,12 +236,38 @@ void VelodyneInterface::stopActivity()
                   << ". It has been terminated"
                   );
     }
+    conversionPool_.stop();
     delete shmem_; shmem_ = NULL;
+    scanRing_.close();
+    cloudRing_.close();
+    velodyneData_ = NULL;
+    velodyneCartData_ = NULL;
+    velodyneDataBuffer_.free();
+    velodyneCartDataBuffer_.free();
+    velodyneCloud_ = NULL;
+    velodyneCloudBuffer_.free();
+    scanRecord_.free();
+    if (!sectors_ && (wakeCount_ > 0)) {
+        LOG_INFO("Velodyne revolutions missed: " << missedCount_
+                 << ", wake-up latency: mean " << wakeLatencySum_ / wakeCount_ << " us"
+                 << ", max " << maxWakeLatency_ << " us");
+    }
+}
+
+/// The cloud is allocated here rather than in the conversion thread when
+/// the strategy takes the revolutions as a VelodyneCloud
+void VelodyneInterface::setVelodyneComputingStrategy(VelodyneComputingStrategy * component)
+{
+    if ((NULL != component) && component->usesCloud()) {
+        allocateCloud();
+    }
+    velodyneComputingStrategy = component;
 }
 
 void VelodyneInterface::run()
 {
     LOG_TRACE(BOOST_CURRENT_FUNCTION);
+    tuneCurrentThread("conversion", threadSettings_);
 
     {
         // load lidar corrections
@@ -103,116 +278,369 @@ void VelodyneInterface::run()
 
     //local run variables
     void * ptr; // shmem pointer for reading
-    VelodynePolarData * scan;
-    //    double seuil = 0.001;
-    double dxy, X, Y, Z;
+    revolutionId_ = 0;
+    nextBlock_ = -1;
 
     while (VelodyneInterface::m_isThreadAlive) { // Variable activated by ComponentBase
-        if (shmem_->wait()) {
-            ptr = shmem_->read();
-            memcpy(&velodyneData_, ptr, sizeof(velodyneData_));
-
-            if (NULL != velodyneComputingStrategy) {
-                velodyneComputingStrategy->processRaw(&velodyneData_);
+        if (!sectors_) {
+            if (scanRing_.wait(kScanTimeoutMs)) {
+                road_timerange_t latency = scanRing_.wakeLatency();
+                if (latency >= 0) {
+                    ++wakeCount_;
+                    wakeLatencySum_ += latency;
+                    maxWakeLatency_ = qMax(maxWakeLatency_, latency);
+                }
+                readRevolutions();
+            } else {
+                LOG_ERROR("lidar timeout");
             }
-            scan = &velodyneData_;
+        } else if (shmem_->wait()) {
+            ptr = shmem_->read();
+            processSector(ptr);
+        } else {
+            LOG_ERROR("lidar timeout");
+        }
+    }
+    LOG_INFO("ended thread execution");
+}
 
-            int pointCountTotal = 0;
-            //velodyneCartData_.scanCount=scan->scanCount;
-            if (VELODYNE_SCAN_SIZE < scan->range) {
-                LOG_WARN("scan size (" << scan->range << ") greater than maximal allowed size (" << VELODYNE_SCAN_SIZE << ")");
+/// Processes the newest revolution, or with readLatest="false" the
+/// revolutions published since the last one read, in order. When the
+/// conversion is slower than the sensor, the revolutions overwritten in the
+/// ring before being read are skipped.
+///
+/// Unless the strategy needs the raw data, a revolution is converted where
+/// it lies in the ring. If the writer overwrote its slot meanwhile, the
+/// conversion is discarded and the next revolution is copied out of the
+/// ring before being converted.
+void VelodyneInterface::readRevolutions()
+{
+    bool inPlace = (NULL == velodyneComputingStrategy) || !velodyneComputingStrategy->usesRawData();
+    int size;
+    int missed;
+    forever {
+        if (inPlace) {
+            const void * record = scanRing_.acquire(readLatest_, &size, &missed);
+            if (!record) {
+                break;
             }
-            velodyneCartData_.range = scan->range;
-            velodyneCartData_.time=scan->time;
-            velodyneCartData_.timerange=scan->timerange;
-
-            for (int block=0; block < scan->range /*VELODYNE_SCAN_SIZE*/; ++block) {
-                const double kFieldOfViewRadians = Geodesie::Deg2Rad(26.8 / 64.0);
-                float alphaRadians = Geodesie::Deg2Rad((scan->polarData[block].angle) / 100.0);
-                float betaRadians = 0.0;
-                int k = 0;
-
-                unsigned blockSignature = scan->polarData[block].block;
-                switch (blockSignature) {
-                case kVelodyneUpperBlock:
-                    betaRadians = Geodesie::Deg2Rad(2) - kFieldOfViewRadians * 32;
-                    k=0;
-                    break;
-                case kVelodyneLowerBlock:
-                    betaRadians = Geodesie::Deg2Rad(2) - kFieldOfViewRadians * 64;
-                    k=32;
-                    break;
-                default:
-                    LOG_WARN("invalid signature in block " << block << ", signature = " << blockSignature);
-                    continue;
+            reportMissed(missed);
+            bool converted = convertInPlace(record);
+            if (scanRing_.release()) {
+                if (converted) {
+                    processConverted();
                 }
+                continue;
+            }
+            // the revolution is lost like those overwritten before being read
+            ++missedCount_;
+            LOG_DEBUG("Velodyne revolution " << scanRing_.position() << " overwritten during its conversion");
+        }
 
-                //   qDebug() << "Velodyne : Cart :" << block << scan->range << alpha << beta;
-                velodyneCartData_.Data[block].alpha=alphaRadians;
-                velodyneCartData_.Data[block].beta=betaRadians;
-                velodyneCartData_.Data[block].block=scan->polarData[block].block;
+        if (scanRing_.read(scanRecord_.data(), (int) scanRecord_.size(), readLatest_, &missed) <= 0) {
+            break;
+        }
+        reportMissed(missed);
+        processRevolution(scanRecord_.data());
+    }
+}
 
-                for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
-                    if (0 == scan->polarData[block].rawPoints[iPoint].distance) {
-                        // point at scanner
-                        continue;
-                    }
+/// Skipping revolutions is expected when jumping to the newest one
+void VelodyneInterface::reportMissed(int missed)
+{
+    if (missed <= 0) {
+        return;
+    }
+    missedCount_ += missed;
+    if (readLatest_) {
+        LOG_DEBUG(missed << " Velodyne revolutions skipped before revolution " << scanRing_.position());
+    } else {
+        LOG_WARN(missed << " Velodyne revolutions missed before revolution " << scanRing_.position());
+    }
+}
 
-                    float d = (scan->polarData[block].rawPoints[iPoint].distance) / 500.0 + m_distCor[iPoint+k] / 100.0; // increments de 2mm => /500 pour avoir des m + correction (en cm)
-                    /*
-                    if (d < m_seuil) {
-                        break;
-                    }
-                    */
+void VelodyneInterface::processRevolution(void * ptr)
+{
+    // whole VelodynePolarData or compact record holding only the valid blocks
+    if (!readVelodyneScanRecord(ptr, velodyneData_)) {
+        LOG_WARN("corrupted Velodyne record in shared memory");
+        return;
+    }
 
-                    // Application des corrections du LIDAR (cf. doc velodyne)
-                    double cosVertAngle = cos(betaRadians);
-                    double sinVertAngle = sin(betaRadians);
+    if (NULL != velodyneComputingStrategy) {
+        velodyneComputingStrategy->processRaw(velodyneData_);
+    }
 
-                    /*  if ( -1.8< d * sinVertAngle + m_vOffsetCor[iPoint+k] / 100.0 * cosVertAngle)
-                        continue;*/
+    //velodyneCartData_->scanCount=scan->scanCount;
+    if (VELODYNE_SCAN_SIZE < velodyneData_->range) {
+        LOG_WARN("scan size (" << velodyneData_->range << ") greater than maximal allowed size (" << VELODYNE_SCAN_SIZE << ")");
+        velodyneData_->range = VELODYNE_SCAN_SIZE;
+    }
+    setConvertedHeader(velodyneData_->range, velodyneData_->time, velodyneData_->timerange);
 
-                    double cosRotAngle = cos(alphaRadians - Geodesie::Deg2Rad(m_rotCor[iPoint+k]));
-                    double sinRotAngle = sin(alphaRadians - Geodesie::Deg2Rad(m_rotCor[iPoint+k]));
+    int pointCountTotal = convertBlocks(velodyneData_->polarData, 0, velodyneData_->range);
+    LOG_DEBUG("Velodyne : Cart :" << "point count total = " << pointCountTotal);
+    processConverted();
+}
 
-                    double hOffsetCorr = m_hOffsetCor[iPoint+k] / 100.0;
-                    double vOffsetCorr = m_vOffsetCor[iPoint+k] / 100.0;
+/// Converts a record of the ring in velodyneCartData_ without copying it
+/// in velodyneData_. Returns false if the record is corrupted.
+bool VelodyneInterface::convertInPlace(const void * record)
+{
+    VelodyneCompactScanHeader info;
+    const VelodyneBlock * blocks = velodyneScanRecordBlocks(record, &info);
+    if (!blocks) {
+        LOG_WARN("corrupted Velodyne record in shared memory");
+        return false;
+    }
 
-                    dxy = d * cosVertAngle - vOffsetCorr * sinVertAngle;
-                    X = dxy * sinRotAngle  - hOffsetCorr * cosRotAngle;  // x
-                    Y = dxy * cosRotAngle  + hOffsetCorr * sinRotAngle;  // y
-                    Z = d   * sinVertAngle + vOffsetCorr * cosVertAngle; // z
+    int range = info.range;
+    if (VELODYNE_SCAN_SIZE < range) {
+        LOG_WARN("scan size (" << range << ") greater than maximal allowed size (" << VELODYNE_SCAN_SIZE << ")");
+        range = VELODYNE_SCAN_SIZE;
+    }
+    setConvertedHeader(range, info.time, info.timerange);
 
-                    // on ajoute le point au vecteur qui sera transmis   la grille
-                    // data.push_back(pt);
-                    velodyneCartData_.Data[block].Points[iPoint].distance=d;
-                    velodyneCartData_.Data[block].Points[iPoint].X=X;
-                    velodyneCartData_.Data[block].Points[iPoint].Y=Y;
-                    velodyneCartData_.Data[block].Points[iPoint].Z=Z;
-                    velodyneCartData_.Data[block].Points[iPoint].intensity=scan->polarData[block].rawPoints[iPoint].intensity;
+    int pointCountTotal = convertBlocks(blocks, 0, range);
+    LOG_DEBUG("Velodyne : Cart :" << "point count total = " << pointCountTotal);
+    return true;
+}
 
-                    ++pointCountTotal;
-                    //  qDebug() << "Velodyne : Cart :" << X << Y << Z << d << alpha << beta << scan->polarData[block].rawPoints[iPoint].intensity<< "N" << n;
+/// Converts the blocks of a sector as soon as it is received. The
+/// revolution is rebuilt in velodyneData_ and velodyneCartData_ and handed
+/// to the strategy as usual when its last sector arrives.
+void VelodyneInterface::processSector(void * ptr)
+{
+    const VelodyneSectorHeader * header = static_cast<const VelodyneSectorHeader *>(ptr);
+    if ((kVelodyneSectorMagic != header->magic) || (header->firstBlock < 0) || (header->blockCount < 0)
+            || (header->firstBlock + header->blockCount > VELODYNE_SCAN_SIZE)
+            || (header->packetCount < 0) || (header->packetCount > VELODYNE_MAX_PACKETS_PER_SCAN)) {
+        LOG_WARN("corrupted Velodyne sector in shared memory");
+        return;
+    }
 
-                    // on met a jour beta
-                    betaRadians += kFieldOfViewRadians; // 26.8 FOV vertical
+    if ((nextBlock_ < 0) || (header->revolutionId != revolutionId_)) {
+        // new revolution
+        revolutionId_ = header->revolutionId;
+        nextBlock_ = 0;
+        velodyneData_->time = header->time;
+        velodyneData_->packetCount = 0;
+        velodyneCartData_->time = header->time;
+    }
+    if (header->firstBlock != nextBlock_) {
+        // the sectors overwritten in the shared memory before being read would
+        // otherwise keep the blocks of the previous revolution
+        LOG_DEBUG("Velodyne sectors missed in revolution " << revolutionId_
+                  << ", blocks " << nextBlock_ << " to " << header->firstBlock);
+        invalidateBlocks(nextBlock_, header->firstBlock);
+    }
+
+    // the packet which started in the previous sector is already known, unless that sector was missed
+    const VelodynePacketTiming * timing = reinterpret_cast<const VelodynePacketTiming *>(header + 1);
+    for (int i = 0; i < header->packetCount; ++i) {
+        int count = velodyneData_->packetCount;
+        if ((count > 0) && (timing[i].firstBlock <= velodyneData_->packetTiming[count - 1].firstBlock)) {
+            continue;
+        }
+        if (count < VELODYNE_MAX_PACKETS_PER_SCAN) {
+            velodyneData_->packetTiming[count] = timing[i];
+            velodyneData_->packetCount = count + 1;
+        }
+    }
+
+    memcpy(&velodyneData_->polarData[header->firstBlock], timing + header->packetCount, header->blockCount * VELODYNE_BLOCK_SIZE);
+    int pointCount = convertBlocks(velodyneData_->polarData, header->firstBlock, header->firstBlock + header->blockCount);
+    nextBlock_ = header->firstBlock + header->blockCount;
+    LOG_TRACE("Velodyne : sector " << header->sectorId << " of revolution " << revolutionId_
+              << " : point count = " << pointCount);
+    if (NULL != velodyneComputingStrategy) {
+        velodyneComputingStrategy->processSector(velodyneCartData_, header->firstBlock, header->blockCount);
+    }
+
+    if (header->flags & kVelodyneLastSector) {
+        velodyneData_->range = nextBlock_;
+        velodyneData_->timerange = header->timerange;
+        setConvertedHeader(nextBlock_, velodyneData_->time, header->timerange);
+        if (NULL != velodyneComputingStrategy) {
+            velodyneComputingStrategy->processRaw(velodyneData_);
+        }
+        processConverted();
+        // wait for the next revolution
+        nextBlock_ = -1;
+    }
+}
+
+/// Converts the blocks [firstBlock, endBlock) of a revolution in velodyneCartData_
+/// and velodyneCloud_, as needed, and returns the number of points, once all the
+/// threads of the pool are done
+int VelodyneInterface::convertBlocks(const VelodyneBlock * blocks, int firstBlock, int endBlock)
+{
+    int pointCount = 0;
+    if (cloudEnabled()) {
+        pointCount = conversionPool_.convert(blocks, firstBlock, endBlock, velodyneCloud_);
+    }
+    if (cartDataEnabled()) {
+        pointCount = conversionPool_.convert(blocks, firstBlock, endBlock, velodyneCartData_);
+    }
+    return pointCount;
+}
+
+/// Marks the blocks [firstBlock, endBlock) of the revolution as missing: their
+/// signatures are cleared in velodyneData_ and velodyneCartData_, and their
+/// points are null and not valid in velodyneCloud_
+void VelodyneInterface::invalidateBlocks(int firstBlock, int endBlock)
+{
+    for (int block = firstBlock; block < endBlock; ++block) {
+        velodyneData_->polarData[block].block = 0;
+        velodyneCartData_->Data[block].block = 0;
+    }
+    if ((firstBlock < endBlock) && cloudEnabled()) {
+        const int offset = firstBlock * kVelodynePointsPerBlock;
+        const int count = (endBlock - firstBlock) * kVelodynePointsPerBlock;
+        memset(velodyneCloud_->x + offset, 0, count * sizeof(float));
+        memset(velodyneCloud_->y + offset, 0, count * sizeof(float));
+        memset(velodyneCloud_->z + offset, 0, count * sizeof(float));
+        memset(velodyneCloud_->intensity + offset, 0, count * sizeof(float));
+        memset(velodyneCloud_->distance + offset, 0, count * sizeof(float));
+        memset(velodyneCloud_->valid + offset, 0, count);
+        memset(velodyneCloud_->laser + offset, 0, count);
+        memset(velodyneCloud_->azimuth + offset, 0, count * sizeof(uint16_t));
+    }
+}
+
+/// Allocates the VelodyneCloud once. When it cannot be allocated, the
+/// strategy gets the VelodyneCartData instead.
+void VelodyneInterface::allocateCloud()
+{
+    if (NULL != velodyneCloud_) {
+        return;
+    }
+    if (!velodyneCloudBuffer_.allocate(sizeof(VelodyneCloud), memorySettings_)) {
+        LOG_ERROR("cannot allocate the Velodyne cloud, the revolutions are converted in the cartesian data");
+        return;
+    }
+    velodyneCloud_ = static_cast<VelodyneCloud *>(velodyneCloudBuffer_.data());
+}
+
+/// True when the strategy takes the revolutions as a VelodyneCloud and the
+/// cloud was allocated
+bool VelodyneInterface::cloudEnabled() const
+{
+    return (NULL != velodyneCloud_) && (NULL != velodyneComputingStrategy) && velodyneComputingStrategy->usesCloud();
+}
+
+/// The VelodyneCartData is not filled when the strategy takes a VelodyneCloud,
+/// unless the sectors or the published revolutions need it
+bool VelodyneInterface::cartDataEnabled()
+{
+    return !cloudEnabled() || sectors_ || (cloudRing_.isOpen() && (CartesianCloud == cloudFormat_));
+}
+
+/// The header of velodyneCartData_ is always set, even when its blocks are not converted
+void VelodyneInterface::setConvertedHeader(int range, road_time_t time, road_timerange_t timerange)
+{
+    velodyneCartData_->range = range;
+    velodyneCartData_->time = time;
+    velodyneCartData_->timerange = timerange;
+    if (cloudEnabled()) {
+        velodyneCloud_->range = range;
+        velodyneCloud_->time = time;
+        velodyneCloud_->timerange = timerange;
+    }
+}
+
+/// Publishes the converted revolution and hands it to the strategy
+void VelodyneInterface::processConverted()
+{
+    publishCloud();
+    if (NULL == velodyneComputingStrategy) {
+        return;
+    }
+    if (cloudEnabled()) {
+        velodyneComputingStrategy->processCloud(velodyneCloud_);
+    } else {
+        velodyneComputingStrategy->processCorrected(velodyneCartData_);
+    }
+}
+
+/// Publishes the converted revolution in velodyneCartData_, or in velodyneCloud_
+/// when only it is filled, for the other processes, with the time of the polar
+/// data. The compact cloud is written in place in the ring and only holds the
+/// points with a return.
+void VelodyneInterface::publishCloud()
+{
+    if (!cloudRing_.isOpen()) {
+        return;
+    }
+    if (CartesianCloud == cloudFormat_) {
+        cloudRing_.publish(velodyneCartData_, sizeof(VelodyneCartData));
+        return;
+    }
+
+    VelodyneCloudHeader * header = static_cast<VelodyneCloudHeader *>(cloudRing_.reserve());
+    VelodyneCloudPoint * points = reinterpret_cast<VelodyneCloudPoint *>(header + 1);
+    int pointCount = 0;
+    if (cartDataEnabled()) {
+        for (int block = 0; block < velodyneCartData_->range; ++block) {
+            const VelodyneCartBlock & cartBlock = velodyneCartData_->Data[block];
+            if ((kVelodyneUpperBlock != cartBlock.block) && (kVelodyneLowerBlock != cartBlock.block)) {
+                continue;
+            }
+            for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+                const VelodyneCartPoint & point = cartBlock.Points[iPoint];
+                if (0 == point.distance) {
+                    continue;
                 }
+                points[pointCount].x = (float) point.X;
+                points[pointCount].y = (float) point.Y;
+                points[pointCount].z = (float) point.Z;
+                points[pointCount].intensity = point.intensity;
+                ++pointCount;
             }
-            LOG_DEBUG("Velodyne : Cart :" << "point count total = " << pointCountTotal);
-            if (NULL != velodyneComputingStrategy) {
-                velodyneComputingStrategy->processCorrected(&velodyneCartData_);
+        }
+    } else {
+        const VelodyneCloud * cloud = velodyneCloud_;
+        const int cloudPointCount = cloud->range * kVelodynePointsPerBlock;
+        for (int i = 0; i < cloudPointCount; ++i) {
+            if (!cloud->valid[i]) {
+                continue;
             }
-        } else {
-            LOG_ERROR("lidar timeout");
+            points[pointCount].x = cloud->x[i];
+            points[pointCount].y = cloud->y[i];
+            points[pointCount].z = cloud->z[i];
+            points[pointCount].intensity = cloud->intensity[i];
+            ++pointCount;
         }
     }
-    LOG_INFO("ended thread execution");
+    header->magic = kVelodyneCloudMagic;
+    header->range = velodyneCartData_->range;
+    header->pointCount = pointCount;
+    header->time = velodyneCartData_->time;
+    header->timerange = velodyneCartData_->timerange;
+    cloudRing_.commit(sizeof(VelodyneCloudHeader) + pointCount * sizeof(VelodyneCloudPoint));
+}
+
+/// Reads the items of a list of db.xml, the first one being laser 0
+static void readLaserList(const QDomElement & list, int values[VelodyneCalibration::kLaserCount])
+{
+    int i = 0;
+    QDomElement item=list.firstChild().toElement();
+    while (!item.isNull() && (i < VelodyneCalibration::kLaserCount)) {
+        if (item.tagName() == "item") {
+            values[i++] = item.text().toInt();
+        }
+        item = item.nextSibling().toElement();
+    }
 }
 
 void VelodyneInterface::loadCorrections(const std::string & filename)
 {
     LOG_TRACE(BOOST_CURRENT_FUNCTION);
 
+    // without a file, the conversion uses the nominal calibration
+    VelodyneCalibration calibration;
+    converter_.setCalibration(calibration);
+
     /////////////////////////////////////////
     // Read the DOM tree form file
     QFile f(filename.c_str());
@@ -238,6 +666,15 @@ void VelodyneInterface::loadCorrections(const std::string & filename)
     // Traverse its children
     QDomElement child=root.firstChild().toElement();
     while (!child.isNull()) {
+        if (child.tagName() == "distLSB_") {
+            calibration.distLSB = child.text().toDouble();
+        }
+        if (child.tagName() == "minIntensity_") {
+            readLaserList(child, calibration.minIntensity);
+        }
+        if (child.tagName() == "maxIntensity_") {
+            readLaserList(child, calibration.maxIntensity);
+        }
         if (child.tagName() == "points_") {
             QDomElement item=child.firstChild().toElement();
             while (!item.isNull()) {
@@ -245,26 +682,27 @@ void VelodyneInterface::loadCorrections(const std::string & filename)
                     QDomElement px=item.firstChild().toElement();
                     while (!px.isNull()) {
                         if (px.tagName() == "px") {
-                            int i = 0;
+                            int i = -1;
                             QDomElement cor=px.firstChild().toElement();
                             while (!cor.isNull()) {
                                 if (cor.tagName() == "id_") {
                                     i = cor.text().toInt();
-                                }
-                                if (cor.tagName() == "rotCorrection_")
-                                    m_rotCor[i] = cor.text().toDouble();
-
-                                if (cor.tagName() == "vertCorrection_") {
-                                    m_vertCor[i] = cor.text().toDouble();
-                                }
-                                if (cor.tagName() == "distCorrection_") {
-                                    m_distCor[i] = cor.text().toDouble();
-                                }
-                                if (cor.tagName() == "horizOffsetCorrection_") {
-                                    m_hOffsetCor[i] = cor.text().toDouble();
-                                }
-                                if (cor.tagName() == "vertOffsetCorrection_") {
-                                    m_vOffsetCor[i] = cor.text().toDouble();
+                                    if ((i < 0) || (i >= VelodyneCalibration::kLaserCount)) {
+                                        LOG_WARN("invalid laser id " << i << " in '" << filename.c_str() << "'");
+                                        break;
+                                    }
+                                } else if (i < 0) {
+                                    // the corrections before id_ cannot be assigned
+                                } else if (cor.tagName() == "rotCorrection_") {
+                                    calibration.rotCorrection[i] = cor.text().toDouble();
+                                } else if (cor.tagName() == "vertCorrection_") {
+                                    calibration.vertCorrection[i] = cor.text().toDouble();
+                                } else if (cor.tagName() == "distCorrection_") {
+                                    calibration.distCorrection[i] = cor.text().toDouble();
+                                } else if (cor.tagName() == "horizOffsetCorrection_") {
+                                    calibration.horizOffsetCorrection[i] = cor.text().toDouble();
+                                } else if (cor.tagName() == "vertOffsetCorrection_") {
+                                    calibration.vertOffsetCorrection[i] = cor.text().toDouble();
                                 }
                                 cor = cor.nextSibling().toElement();
                             }
@@ -277,6 +715,9 @@ void VelodyneInterface::loadCorrections(const std::string & filename)
         }
         child = child.nextSibling().toElement();
     }
+
+    // the trigonometry of the calibration is computed once here, not for each point
+    converter_.setCalibration(calibration);
 }
 
 } // namespace pacpus
@@ -14,7 +14,13 @@
 //#include "LibSensorComponent.h"
 #include "kernel/ComponentBase.h"
 #include "../VelodyneComponent/structure_velodyne.h"
+#include "../VelodyneComponent/VelodyneMemory.h"
+#include "../VelodyneComponent/VelodyneScanRing.h"
+#include "../VelodyneComponent/VelodyneThreadTuning.h"
 #include "structure_velodyne_cart.h"
+#include "VelodyneCloud.h"
+#include "VelodyneConversionPool.h"
+#include "VelodyneConverter.h"
 //#include "structure_IGN.h"
 
 
@@ -42,6 +48,17 @@ struct SENSORCOMPONENT_API VelodyneComputingStrategy
 {
     virtual void processRaw(VelodynePolarData * polarScanData) = 0;
     virtual void processCorrected(VelodyneCartData * cartesianScanData) = 0;
+    /// blockCount blocks from firstBlock were just converted, before the revolution is complete.
+    /// Only called when the sectors are read, does nothing by default.
+    virtual void processSector(VelodyneCartData * /* cartesianScanData */, int /* firstBlock */, int /* blockCount */) {}
+    /// When false, the revolutions are converted in place in the shared memory and processRaw()
+    /// is not called, which saves a copy of each revolution. True by default.
+    virtual bool usesRawData() const { return true; }
+    /// When true, the revolutions are converted in a VelodyneCloud given to processCloud()
+    /// instead of processCorrected(). False by default.
+    virtual bool usesCloud() const { return false; }
+    /// Called with each converted revolution when usesCloud() is true, does nothing by default.
+    virtual void processCloud(VelodyneCloud * /* cloud */) {}
 };
 
 class SENSORCOMPONENT_API VelodyneInterface
@@ -52,6 +69,7 @@ class SENSORCOMPONENT_API VelodyneInterface
 
 private:
     static const char * SHARED_MEMORY_NAME;
+    static const char * SECTOR_SHARED_MEMORY_SUFFIX;
 
 public:
     static const char * COMPONENT_NAME;
@@ -73,10 +91,24 @@ public:
     virtual void startActivity();
     virtual COMPONENT_CONFIGURATION configureComponent(XmlComponentConfig config);
 
-    void setVelodyneComputingStrategy(VelodyneComputingStrategy * component) {velodyneComputingStrategy =component;}
+    void setVelodyneComputingStrategy(VelodyneComputingStrategy * component);
 
 protected:
     void run();
+    void readRevolutions();
+    void reportMissed(int missed);
+    bool readIntegerProperty(const std::string & name, int min, int max, int * value);
+    void processRevolution(void * ptr);
+    bool convertInPlace(const void * record);
+    void publishCloud();
+    void processSector(void * ptr);
+    int convertBlocks(const VelodyneBlock * blocks, int firstBlock, int endBlock);
+    void invalidateBlocks(int firstBlock, int endBlock);
+    void allocateCloud();
+    bool cloudEnabled() const;
+    bool cartDataEnabled();
+    void setConvertedHeader(int range, road_time_t time, road_timerange_t timerange);
+    void processConverted();
 
 private:
     bool recording_;
@@ -84,22 +116,62 @@ private:
     FILE * dbt2txtFile_;
     QString filePath_;
     bool m_isThreadAlive;
-
-    static const int kVelodyneLayerCount = 64;
-    double m_rotCor[kVelodyneLayerCount];
-    double m_vertCor[kVelodyneLayerCount];
-    double m_distCor[kVelodyneLayerCount];
-    double m_hOffsetCor[kVelodyneLayerCount];
-    double m_vOffsetCor[kVelodyneLayerCount];
+    /// read the azimuth sectors streamed by the VelodyneComponent instead of the complete revolutions
+    bool sectors_;
+    /// revolution whose sectors are being converted
+    uint32_t revolutionId_;
+    /// block expected at the start of the next sector, -1 before the first sector of a revolution
+    int nextBlock_;
 
     void loadCorrections(const std::string & file);
+    /// tables of the conversion, built from the calibration
+    VelodyneConverter converter_;
+    /// threads sharing the conversion of a revolution, 1 for the conversion thread alone
+    int conversionThreads_;
+    VelodyneConversionPool conversionPool_;
 
-    // The shared memory where data are provided
+    // The shared memory where the sectors are provided
     ShMem * shmem_;
+    // The ring of the shared memory where the revolutions are provided
+    VelodyneScanRingReader scanRing_;
+    QString shmemName_;
+    /// same number of slots as the VelodyneComponent
+    int shmemSlots_;
+    /// record copied out of the ring
+    VelodyneBuffer scanRecord_;
+    /// convert the newest revolution only, skipping the older ones not read yet
+    bool readLatest_;
+    /// revolutions skipped or overwritten before being read
+    quint64 missedCount_;
+    /// time between the publication of a revolution and the wake-up of the conversion thread
+    quint64 wakeCount_;
+    quint64 wakeLatencySum_;
+    road_timerange_t maxWakeLatency_;
+
+    /// ring where the converted revolutions are published, when cloudShmem is set
+    VelodyneScanRingWriter cloudRing_;
+    QString cloudShmemName_;
+    /// what is published in cloudRing_
+    enum CloudFormat {
+        /// VelodyneCloudHeader + float XYZI of the returns
+        XyziCloud,
+        /// whole VelodyneCartData
+        CartesianCloud
+    };
+    CloudFormat cloudFormat_;
+    /// core and priority of the conversion thread
+    VelodyneThreadSettings threadSettings_;
     QMutex mutex;
-    //incoming LidarData
-    VelodynePolarData velodyneData_;
-    VelodyneCartData velodyneCartData_;
+    /// backing of the revolution buffers and of the shared memory
+    VelodyneMemorySettings memorySettings_;
+    VelodyneBuffer velodyneDataBuffer_;
+    VelodyneBuffer velodyneCartDataBuffer_;
+    //incoming LidarData, allocated in velodyneDataBuffer_ and velodyneCartDataBuffer_
+    VelodynePolarData * velodyneData_;
+    VelodyneCartData * velodyneCartData_;
+    /// revolution converted in arrays, allocated when the strategy takes it
+    VelodyneBuffer velodyneCloudBuffer_;
+    VelodyneCloud * velodyneCloud_;
 
     VelodyneComputingStrategy * velodyneComputingStrategy;
 
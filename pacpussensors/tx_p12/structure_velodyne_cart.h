@@ -37,6 +37,32 @@ typedef struct VelodyneCartData
   short range;                  // not all polarData are useful, use range to know until which index you can use the data
 }VelodyneCartData;
 
+// VelodyneCloudHeader::magic, must differ from the magics of structure_velodyne.h
+// (kVelodyneCompactScanMagic, kVelodynePacketRecordMagic, kVelodyneSectorMagic)
+// so that a cloud is never mistaken for a record of the acquisition
+#define kVelodyneCloudMagic 0x5658
+
+// size : 2 + 2 + 4 + 8 + 4 = 20 bytes
+// header of a compact cloud, followed by pointCount VelodyneCloudPoint
+typedef struct VelodyneCloudHeader
+{
+  unsigned short magic;         // kVelodyneCloudMagic
+  short range;                  // blocks of the revolution the points come from
+  int pointCount;               // points following the header, only the returns
+  road_time_t time;             // same time as the polar data of the revolution
+  road_timerange_t timerange;   // same timerange as the polar data of the revolution
+}VelodyneCloudHeader;
+
+// 16 bytes size
+typedef struct VelodyneCloudPoint
+{
+  float x, y, z;                // in meter
+  float intensity;              // 255 most intense return
+}VelodyneCloudPoint;
+
 #pragma pack(pop)
 
+// largest compact cloud, every point of every block returning
+#define VELODYNE_CLOUD_MAX_RECORD_SIZE (sizeof(VelodyneCloudHeader) + VELODYNE_SCAN_SIZE * 32 * sizeof(VelodyneCloudPoint))
+
 #endif // STRUCTURE_VELODYNE_CART_H
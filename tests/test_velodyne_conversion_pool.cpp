@@ -0,0 +1,105 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   test_velodyne_conversion_pool.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Checks that a revolution converted by several threads is
+//              identical to the one converted by a single thread
+//
+*********************************************************************/
+
+#include "VelodyneConversionPool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace pacpus;
+
+static VelodyneCartData sSingleCart;
+static VelodyneCartData sPoolCart;
+static VelodyneCloud sSingleCloud;
+static VelodyneCloud sPoolCloud;
+
+//////////////////////////////////////////////////////////////////////////
+/// Random revolution with a block of invalid signature
+static void makeBlocks(std::vector<VelodyneBlock> & blocks)
+{
+    blocks.resize(VELODYNE_SCAN_SIZE);
+    for (int block = 0; block < VELODYNE_SCAN_SIZE; ++block) {
+        blocks[block].block = (block % 2) ? kVelodyneLowerBlock : kVelodyneUpperBlock;
+        blocks[block].angle = (uint16_t) (block / 2 * 17 % VelodyneConverter::kAzimuthCount);
+        for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+            blocks[block].rawPoints[iPoint].distance = (uint16_t) ((rand() % 10) ? rand() % 0x10000 : 0);
+            blocks[block].rawPoints[iPoint].intensity = (uint8_t) (rand() % 0x100);
+        }
+    }
+    blocks[1001].block = 0x1234;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Converts the blocks [firstBlock, endBlock) with threadCount threads and
+/// compares the result with a single thread, returns false if it differs
+static bool comparePool(const VelodyneConverter & converter, const std::vector<VelodyneBlock> & blocks,
+                        int firstBlock, int endBlock, int threadCount)
+{
+    VelodyneConversionPool pool(converter);
+    pool.start(1, VelodyneThreadSettings());
+    memset(&sSingleCart, 0x7f, sizeof(sSingleCart));
+    memset(&sSingleCloud, 0x7f, sizeof(sSingleCloud));
+    const int singleCartCount = pool.convert(&blocks[0], firstBlock, endBlock, &sSingleCart);
+    const int singleCloudCount = pool.convert(&blocks[0], firstBlock, endBlock, &sSingleCloud);
+
+    pool.start(threadCount, VelodyneThreadSettings());
+    memset(&sPoolCart, 0x7f, sizeof(sPoolCart));
+    memset(&sPoolCloud, 0x7f, sizeof(sPoolCloud));
+    const int poolCartCount = pool.convert(&blocks[0], firstBlock, endBlock, &sPoolCart);
+    const int poolCloudCount = pool.convert(&blocks[0], firstBlock, endBlock, &sPoolCloud);
+    pool.stop();
+
+    bool identical = true;
+    if ((singleCartCount != poolCartCount) || (0 != memcmp(&sSingleCart, &sPoolCart, sizeof(sSingleCart)))) {
+        printf("%d threads, blocks [%d, %d): cart data differs, %d points instead of %d\n",
+               threadCount, firstBlock, endBlock, poolCartCount, singleCartCount);
+        identical = false;
+    }
+    if ((singleCloudCount != poolCloudCount) || (0 != memcmp(&sSingleCloud, &sPoolCloud, sizeof(sSingleCloud)))) {
+        printf("%d threads, blocks [%d, %d): cloud differs, %d points instead of %d\n",
+               threadCount, firstBlock, endBlock, poolCloudCount, singleCloudCount);
+        identical = false;
+    }
+    if (singleCartCount != singleCloudCount) {
+        printf("blocks [%d, %d): %d points in the cart data, %d in the cloud\n",
+               firstBlock, endBlock, singleCartCount, singleCloudCount);
+        identical = false;
+    }
+    return identical;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main()
+{
+    srand(24);
+    std::vector<VelodyneBlock> blocks;
+    makeBlocks(blocks);
+    VelodyneConverter converter;
+
+    int failureCount = 0;
+    const int kThreadCounts[] = { 2, 3, 4, 8 };
+    for (int t = 0; t < 4; ++t) {
+        // whole revolution, and a sector starting on a lower block
+        if (!comparePool(converter, blocks, 0, VELODYNE_SCAN_SIZE, kThreadCounts[t])) {
+            ++failureCount;
+        }
+        if (!comparePool(converter, blocks, 37, 3001, kThreadCounts[t])) {
+            ++failureCount;
+        }
+    }
+    printf("%d conversions differ from the single thread\n", failureCount);
+
+    return (0 == failureCount) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,217 @@
+/*********************************************************************
+//  created:    2026/10/16
+//  filename:   test_velodyne_kernels.cpp
+//
+//              Copyright Heudiasyc UMR UTC/CNRS 6599
+//
+//  version:    $Id: $
+//
+//  purpose:    Compares the kernels of the Velodyne conversion that the
+//              build and the processor support with the scalar one, and
+//              the conversion with a direct computation in double
+//
+*********************************************************************/
+
+#include "VelodyneConverter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace pacpus;
+
+/// The kernels do the same float operations in the same order, the
+/// tolerance only covers the compilers contracting them
+static const float kKernelTolerance = 1e-5f;
+
+/// The conversion in float with tabulated cosines stays well below the
+/// 2 mm resolution of the raw distances
+static const double kReferenceTolerance = 1e-3;
+
+static const double kPi = 3.14159265358979323846;
+
+static VelodyneCloud sScalarCloud;
+static VelodyneCloud sKernelCloud;
+
+//////////////////////////////////////////////////////////////////////////
+/// Calibration far from the nominal one, every correction being used
+static VelodyneCalibration makeCalibration()
+{
+    VelodyneCalibration calibration;
+    for (int i = 0; i < VelodyneCalibration::kLaserCount; ++i) {
+        calibration.rotCorrection[i] = -5.0 + 10.0 * rand() / RAND_MAX;
+        calibration.vertCorrection[i] += -0.5 + 1.0 * rand() / RAND_MAX;
+        calibration.distCorrection[i] = -150.0 + 300.0 * rand() / RAND_MAX;
+        calibration.horizOffsetCorrection[i] = -3.0 + 6.0 * rand() / RAND_MAX;
+        calibration.vertOffsetCorrection[i] = 10.0 + 20.0 * rand() / RAND_MAX;
+        calibration.minIntensity[i] = rand() % 40;
+        calibration.maxIntensity[i] = 200 + rand() % 56;
+    }
+    return calibration;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void fillBlock(VelodyneBlock & block, uint16_t signature, uint16_t angle, int distance, int intensity)
+{
+    block.block = signature;
+    block.angle = angle;
+    for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+        block.rawPoints[iPoint].distance = (uint16_t) ((distance < 0) ? rand() % 0x10000 : distance);
+        block.rawPoints[iPoint].intensity = (uint8_t) ((intensity < 0) ? rand() % 0x100 : intensity);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// A revolution starting with the edge cases, for the upper and the lower
+/// blocks: null and maximal distances and intensities at the first and the
+/// last azimuths, then an invalid signature, then random blocks
+static void makeBlocks(std::vector<VelodyneBlock> & blocks)
+{
+    static const uint16_t kSignatures[] = { kVelodyneUpperBlock, kVelodyneLowerBlock };
+    static const uint16_t kAngles[] = { 0, 35999 };
+    static const int kDistances[] = { 0, 0xFFFF, -1 };
+    static const int kIntensities[] = { 0, 255, -1 };
+
+    blocks.resize(VELODYNE_SCAN_SIZE);
+    int block = 0;
+    for (int s = 0; s < 2; ++s) {
+        for (int a = 0; a < 2; ++a) {
+            for (int d = 0; d < 3; ++d) {
+                for (int i = 0; i < 3; ++i) {
+                    fillBlock(blocks[block++], kSignatures[s], kAngles[a], kDistances[d], kIntensities[i]);
+                }
+            }
+        }
+    }
+    fillBlock(blocks[block++], 0x1234, 0, -1, -1);
+    for (; block < VELODYNE_SCAN_SIZE; ++block) {
+        fillBlock(blocks[block], (block % 2) ? kVelodyneLowerBlock : kVelodyneUpperBlock,
+                  (uint16_t) (rand() % VelodyneConverter::kAzimuthCount), -1, -1);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+static bool near(float a, float b, float tolerance)
+{
+    return fabs(a - b) <= tolerance;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Compares the points of two clouds, returns the number of differences
+static int compareClouds(const VelodyneCloud & expected, const VelodyneCloud & actual, const char * kernelName)
+{
+    int errorCount = 0;
+    for (int i = 0; i < VelodyneCloud::kMaxPointCount; ++i) {
+        if ((expected.valid[i] != actual.valid[i])
+                || (expected.intensity[i] != actual.intensity[i])
+                || !near(expected.distance[i], actual.distance[i], kKernelTolerance)
+                || !near(expected.x[i], actual.x[i], kKernelTolerance)
+                || !near(expected.y[i], actual.y[i], kKernelTolerance)
+                || !near(expected.z[i], actual.z[i], kKernelTolerance)) {
+            if (errorCount < 10) {
+                printf("%s: point %d of block %d differs: valid %d/%d intensity %g/%g distance %g/%g"
+                       " x %g/%g y %g/%g z %g/%g\n",
+                       kernelName, i % kVelodynePointsPerBlock, i / kVelodynePointsPerBlock,
+                       expected.valid[i], actual.valid[i], expected.intensity[i], actual.intensity[i],
+                       expected.distance[i], actual.distance[i], expected.x[i], actual.x[i],
+                       expected.y[i], actual.y[i], expected.z[i], actual.z[i]);
+            }
+            ++errorCount;
+        }
+    }
+    return errorCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Compares the points of cloud with the ones computed in double by cos()
+/// and sin() from the calibration, returns the number of differences
+static int compareWithReference(const std::vector<VelodyneBlock> & blocks, const VelodyneCalibration & calibration,
+                                const VelodyneCloud & cloud, const char * kernelName)
+{
+    int errorCount = 0;
+    double maxError = 0;
+    for (int block = 0; block < VELODYNE_SCAN_SIZE; ++block) {
+        int firstLaser;
+        if (kVelodyneUpperBlock == blocks[block].block) {
+            firstLaser = 0;
+        } else if (kVelodyneLowerBlock == blocks[block].block) {
+            firstLaser = kVelodynePointsPerBlock;
+        } else {
+            continue;
+        }
+        for (int iPoint = 0; iPoint < kVelodynePointsPerBlock; ++iPoint) {
+            const VelodyneRawPoint & raw = blocks[block].rawPoints[iPoint];
+            const int laser = firstLaser + iPoint;
+            const int i = block * kVelodynePointsPerBlock + iPoint;
+            if (0 == raw.distance) {
+                continue;
+            }
+            const double angle = (blocks[block].angle / 100.0 - calibration.rotCorrection[laser]) * kPi / 180.0;
+            const double beta = calibration.vertCorrection[laser] * kPi / 180.0;
+            const double distance = (raw.distance * calibration.distLSB + calibration.distCorrection[laser]) / 100.0;
+            const double vertOffset = calibration.vertOffsetCorrection[laser] / 100.0;
+            const double horizOffset = calibration.horizOffsetCorrection[laser] / 100.0;
+            const double dxy = distance * cos(beta) - vertOffset * sin(beta);
+            const double x = dxy * sin(angle) - horizOffset * cos(angle);
+            const double y = dxy * cos(angle) + horizOffset * sin(angle);
+            const double z = distance * sin(beta) + vertOffset * cos(beta);
+
+            const double error = std::max(std::max(fabs(cloud.x[i] - x), fabs(cloud.y[i] - y)),
+                                          std::max(fabs(cloud.z[i] - z), fabs(cloud.distance[i] - distance)));
+            maxError = std::max(maxError, error);
+            if (!cloud.valid[i] || (error > kReferenceTolerance)) {
+                if (errorCount < 10) {
+                    printf("%s: point %d of block %d differs from the reference: valid %d"
+                           " distance %g/%g x %g/%g y %g/%g z %g/%g\n",
+                           kernelName, iPoint, block, cloud.valid[i], distance, cloud.distance[i],
+                           x, cloud.x[i], y, cloud.y[i], z, cloud.z[i]);
+                }
+                ++errorCount;
+            }
+        }
+    }
+    printf("%s: maximal error %g m with the reference\n", kernelName, maxError);
+    return errorCount;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main()
+{
+    srand(64);
+    std::vector<VelodyneBlock> blocks;
+    makeBlocks(blocks);
+
+    const VelodyneCalibration calibration = makeCalibration();
+    VelodyneConverter converter;
+    converter.setCalibration(calibration);
+    converter.setKernel(VelodyneConverter::ScalarKernel);
+    const int scalarPointCount = converter.convert(&blocks[0], 0, VELODYNE_SCAN_SIZE, &sScalarCloud);
+
+    int failureCount = 0;
+    // the other kernels are compared with the scalar one
+    if (compareWithReference(blocks, calibration, sScalarCloud, "scalar") > 0) {
+        ++failureCount;
+    }
+    const VelodyneConverter::Kernel kKernels[] = { VelodyneConverter::Sse4Kernel, VelodyneConverter::Avx2Kernel };
+    for (int k = 0; k < 2; ++k) {
+        const char * kernelName = VelodyneConverter::kernelName(kKernels[k]);
+        if (!converter.setKernel(kKernels[k])) {
+            printf("%s: not supported, skipped\n", kernelName);
+            continue;
+        }
+        memset(&sKernelCloud, 0x7f, sizeof(sKernelCloud));
+        const int pointCount = converter.convert(&blocks[0], 0, VELODYNE_SCAN_SIZE, &sKernelCloud);
+        int errorCount = compareClouds(sScalarCloud, sKernelCloud, kernelName);
+        if (pointCount != scalarPointCount) {
+            printf("%s: %d points instead of %d\n", kernelName, pointCount, scalarPointCount);
+            ++errorCount;
+        }
+        printf("%s: %d differences with the scalar kernel\n", kernelName, errorCount);
+        failureCount += (errorCount > 0) ? 1 : 0;
+    }
+
+    return (0 == failureCount) ? EXIT_SUCCESS : EXIT_FAILURE;
+}